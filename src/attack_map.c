@@ -0,0 +1,123 @@
+#include "attack_map.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "attacks.h"
+#include "bitboard.h"
+
+static uint64_t piece_attacks(int piece, int square, uint64_t occupied)
+{
+    switch (piece_type(piece)) {
+    case PAWN:   return pawn_attacks[piece_color(piece)][square];
+    case KNIGHT: return knight_attacks[square];
+    case BISHOP: return bishop_attacks(square, occupied);
+    case ROOK:   return rook_attacks(square, occupied);
+    case QUEEN:  return queen_attacks(square, occupied);
+    case KING:   return king_attacks[square];
+    default:     return 0;
+    }
+}
+
+// replaces the attacks of the piece on square
+static void set_attacks(struct attack_map *map, int square, uint64_t attacks)
+{
+    uint64_t old = map->attacks_from[square];
+    uint64_t changed = old ^ attacks;
+    uint64_t bb = square_bb(square);
+
+    for (uint64_t removed = old & changed; removed;)
+        map->attackers_of[pop_lsb(&removed)] &= ~bb;
+    for (uint64_t added = attacks & changed; added;)
+        map->attackers_of[pop_lsb(&added)] |= bb;
+
+    map->attacks_from[square] = attacks;
+}
+
+void attack_map_init(struct attack_map *map, const struct position *pos)
+{
+    uint64_t occupied = position_occupied(pos);
+
+    memset(map, 0, sizeof(*map));
+    map->colors[WHITE] = pos->colors[WHITE];
+    map->colors[BLACK] = pos->colors[BLACK];
+
+    for (uint64_t pieces = occupied; pieces;) {
+        int square = pop_lsb(&pieces);
+        int piece = position_piece_at(pos, square);
+        uint64_t attacks = piece_attacks(piece, square, occupied);
+
+        map->pieces[square] = (uint8_t)piece;
+        map->attacks_from[square] = attacks;
+        map->by_color[piece_color(piece)] |= attacks;
+        for (; attacks;)
+            map->attackers_of[pop_lsb(&attacks)] |= square_bb(square);
+    }
+}
+
+// squares whose contents a move changes, identical for make and unmake
+static uint64_t move_squares(move m)
+{
+    int from = move_from(m);
+    int to = move_to(m);
+    uint64_t squares = square_bb(from) | square_bb(to);
+
+    if (move_flag(m) == MOVE_EN_PASSANT) {
+        squares |= square_bb(make_square(square_file(to), square_rank(from)));
+    } else if (move_flag(m) == MOVE_CASTLING) {
+        squares |= to > from ? square_bb(to + 1) | square_bb(to - 1)
+                             : square_bb(to - 2) | square_bb(to + 1);
+    }
+
+    return squares;
+}
+
+void attack_map_update(struct attack_map *map, const struct position *pos, move m)
+{
+    uint64_t occupied = position_occupied(pos);
+    uint64_t squares = move_squares(m);
+
+    // sliders looking at a changed square see further or less far now
+    uint64_t sliders = 0;
+    for (uint64_t s = squares; s;)
+        sliders |= map->attackers_of[pop_lsb(&s)];
+    sliders &= pos->pieces[BISHOP] | pos->pieces[ROOK] | pos->pieces[QUEEN];
+    sliders &= ~squares;
+
+    for (uint64_t s = squares; s;) {
+        int square = pop_lsb(&s);
+        int piece = position_piece_at(pos, square);
+
+        map->pieces[square] = (uint8_t)piece;
+        set_attacks(map, square, piece != NO_PIECE ? piece_attacks(piece, square, occupied) : 0);
+    }
+
+    while (sliders) {
+        int square = pop_lsb(&sliders);
+        set_attacks(map, square, piece_attacks(map->pieces[square], square, occupied));
+    }
+
+    map->colors[WHITE] = pos->colors[WHITE];
+    map->colors[BLACK] = pos->colors[BLACK];
+
+    // Rebuilt from the pieces rather than fixed up square by square, which
+    // was slower: there are often more squares whose attackers changed than
+    // there are pieces, and the branch per square mispredicts.
+    for (int color = WHITE; color <= BLACK; ++color) {
+        uint64_t attacked = 0;
+        for (uint64_t pieces = map->colors[color]; pieces;)
+            attacked |= map->attacks_from[pop_lsb(&pieces)];
+        map->by_color[color] = attacked;
+    }
+
+#ifndef NDEBUG
+    struct attack_map fresh;
+    attack_map_init(&fresh, pos);
+    assert(attack_map_equal(map, &fresh));
+#endif
+}
+
+int attack_map_equal(const struct attack_map *a, const struct attack_map *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
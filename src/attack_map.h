@@ -0,0 +1,34 @@
+#ifndef ATTACK_MAP_H
+#define ATTACK_MAP_H
+
+#include <stdint.h>
+
+#include "move.h"
+#include "position.h"
+
+// Attack information for the UI and evaluation, kept up to date move by
+// move instead of being recomputed for every frame or node.
+struct attack_map {
+    uint64_t attacks_from[64];  // squares attacked by the piece on each square
+    uint64_t attackers_of[64];  // squares of the pieces attacking each square
+    uint64_t by_color[2];       // squares attacked by at least one piece of a colour
+    uint64_t colors[2];         // occupancy the map was last updated for
+    uint8_t pieces[64];
+};
+
+// computes the whole map from scratch
+void attack_map_init(struct attack_map *map, const struct position *pos);
+
+// Call after m has been made or unmade on pos. Only the pieces on squares
+// the move touched and the sliders whose rays crossed those squares are
+// recomputed.
+void attack_map_update(struct attack_map *map, const struct position *pos, move m);
+
+int attack_map_equal(const struct attack_map *a, const struct attack_map *b);
+
+static inline uint64_t attack_map_attackers(const struct attack_map *map, int square, int color)
+{
+    return map->attackers_of[square] & map->colors[color];
+}
+
+#endif
@@ -0,0 +1,29 @@
+#include "attacks.h"
+
+#include "attack_tables.h"
+
+int attacks_use_pext;
+
+static int cpu_has_bmi2(void)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return 0;
+#endif
+}
+
+void attacks_init(void)
+{
+    attacks_use_pext = cpu_has_bmi2();
+}
+
+int attacks_select_pext(int use_pext)
+{
+    if (use_pext && !cpu_has_bmi2())
+        return 0;
+
+    attacks_use_pext = use_pext;
+    return 1;
+}
@@ -0,0 +1,86 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <stdint.h>
+
+// Fancy magic bitboard entry for one square. The same mask is used by the
+// BMI2 path, which indexes its own table with pext(occupied, mask) instead
+// of the magic multiply.
+struct magic {
+    uint64_t mask;
+    uint64_t magic;
+    const uint64_t *attacks;
+    const uint64_t *pext_attacks;
+    unsigned int shift;
+};
+
+// All tables are generated at build time by tablegen and are read-only.
+extern const struct magic bishop_magics[64];
+extern const struct magic rook_magics[64];
+
+extern const uint64_t pawn_attacks[2][64];
+extern const uint64_t knight_attacks[64];
+extern const uint64_t king_attacks[64];
+
+// squares strictly between two aligned squares, and the full line through
+// them (both empty when the squares are not on a common rank, file or diagonal)
+extern const uint64_t between_bb[64][64];
+extern const uint64_t line_bb[64][64];
+
+// set by attacks_init() when the CPU supports BMI2
+extern int attacks_use_pext;
+
+// only selects the lookup path, there are no tables to compute
+void attacks_init(void);
+
+// force the magic (0) or pext (1) path, returns 0 if pext is not supported
+int attacks_select_pext(int use_pext);
+
+static inline uint64_t pext_u64_software(uint64_t value, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (value & mask & -mask)
+            result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+static inline uint64_t pext_u64(uint64_t value, uint64_t mask)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // inline asm instead of _pext_u64 so that this compiles (and inlines)
+    // without -mbmi2; it is only executed once BMI2 support was detected
+    uint64_t result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+    return result;
+#else
+    return pext_u64_software(value, mask);
+#endif
+}
+
+static inline uint64_t magic_attacks(const struct magic *m, uint64_t occupied)
+{
+    if (attacks_use_pext)
+        return m->pext_attacks[pext_u64(occupied, m->mask)];
+
+    return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+static inline uint64_t bishop_attacks(int square, uint64_t occupied)
+{
+    return magic_attacks(&bishop_magics[square], occupied);
+}
+
+static inline uint64_t rook_attacks(int square, uint64_t occupied)
+{
+    return magic_attacks(&rook_magics[square], occupied);
+}
+
+static inline uint64_t queen_attacks(int square, uint64_t occupied)
+{
+    return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+}
+
+#endif
@@ -0,0 +1,780 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "attack_map.h"
+#include "attacks.h"
+#include "bitboard.h"
+#include "fen.h"
+#include "movegen.h"
+#include "movepick.h"
+#include "numa_nodes.h"
+#include "position.h"
+#include "search.h"
+#include "see.h"
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t bench_random_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t bench_random(void)
+{
+    bench_random_state ^= bench_random_state >> 12;
+    bench_random_state ^= bench_random_state << 25;
+    bench_random_state ^= bench_random_state >> 27;
+    return bench_random_state * 0x2545F4914F6CDD1DULL;
+}
+
+#define ATTACK_OCCUPANCIES 1024
+#define ATTACK_ROUNDS      4000
+
+static double bench_attack_lookups(const uint64_t *occupancies, uint64_t *checksum)
+{
+    uint64_t sink = 0;
+    double start = now_seconds();
+
+    for (int round = 0; round < ATTACK_ROUNDS; ++round) {
+        for (int i = 0; i < ATTACK_OCCUPANCIES; ++i) {
+            int square = (i + round) & 63;
+            sink ^= queen_attacks(square, occupancies[i]);
+        }
+    }
+
+    double elapsed = now_seconds() - start;
+    *checksum = sink;
+
+    // a queen lookup is one bishop plus one rook lookup
+    return 2.0 * ATTACK_ROUNDS * ATTACK_OCCUPANCIES / elapsed;
+}
+
+static int bench_attacks(void)
+{
+    // sparse random boards with roughly the density of a middlegame
+    static uint64_t occupancies[ATTACK_OCCUPANCIES];
+    for (int i = 0; i < ATTACK_OCCUPANCIES; ++i)
+        occupancies[i] = bench_random() & bench_random();
+
+    uint64_t magic_checksum, pext_checksum;
+
+    attacks_select_pext(0);
+    double magic_rate = bench_attack_lookups(occupancies, &magic_checksum);
+    printf("magic: %8.1f M lookups/s\n", magic_rate / 1e6);
+
+    if (!attacks_select_pext(1)) {
+        printf("pext:  not supported on this CPU\n");
+        return 0;
+    }
+
+    double pext_rate = bench_attack_lookups(occupancies, &pext_checksum);
+    printf("pext:  %8.1f M lookups/s\n", pext_rate / 1e6);
+
+    if (magic_checksum != pext_checksum) {
+        printf("Error: magic and pext lookups disagree\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static const char *bench_fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+#define BENCH_FEN_COUNT (int)(sizeof(bench_fens) / sizeof(bench_fens[0]))
+
+// tree walks without bulk counting so every leaf move is actually made
+static uint64_t walk_make_unmake(struct position *pos, struct undo_stack *stack, int depth)
+{
+    struct move_list list;
+    generate_legal_moves(pos, &list);
+
+    uint64_t moves = (uint64_t)list.count;
+    for (int i = 0; i < list.count; ++i) {
+        position_make_move(pos, stack, list.moves[i]);
+        if (depth > 1)
+            moves += walk_make_unmake(pos, stack, depth - 1);
+        position_unmake_move(pos, stack, list.moves[i]);
+    }
+    return moves;
+}
+
+static uint64_t walk_copy_make(const struct position *pos, int depth)
+{
+    struct move_list list;
+    generate_legal_moves(pos, &list);
+
+    uint64_t moves = (uint64_t)list.count;
+    for (int i = 0; i < list.count; ++i) {
+        struct position child;
+        position_copy_make(pos, &child, list.moves[i]);
+        if (depth > 1)
+            moves += walk_copy_make(&child, depth - 1);
+    }
+    return moves;
+}
+
+#define MAKE_MOVE_DEPTH 4
+
+static int bench_make_move(void)
+{
+    static struct undo_stack stack;
+    uint64_t unmake_moves = 0, copy_moves = 0;
+    double unmake_time = 0.0, copy_time = 0.0;
+
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+
+        double start = now_seconds();
+        unmake_moves += walk_make_unmake(&pos, &stack, MAKE_MOVE_DEPTH);
+        unmake_time += now_seconds() - start;
+
+        start = now_seconds();
+        copy_moves += walk_copy_make(&pos, MAKE_MOVE_DEPTH);
+        copy_time += now_seconds() - start;
+    }
+
+    // both walks also generate moves, so the rates compare the full cycle
+    printf("make/unmake: %llu moves %8.1f M moves/s\n", (unsigned long long)unmake_moves, unmake_moves / unmake_time / 1e6);
+    printf("copy-make:   %llu moves %8.1f M moves/s\n", (unsigned long long)copy_moves, copy_moves / copy_time / 1e6);
+    printf("%s is faster, %s CHESS_COPY_MAKE\n", copy_time < unmake_time ? "copy-make" : "make/unmake",
+           copy_time < unmake_time ? "enable" : "disable");
+
+    if (unmake_moves != copy_moves) {
+        printf("Error: make/unmake and copy-make walks disagree\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// Positions reached by random games from the bench FENs. With only a few
+// distinct inputs the branch predictor learns them, which flatters any
+// parser that branches on every character.
+#define FEN_POSITIONS 4096
+#define FEN_ROUNDS 300
+#define FEN_RANDOM_PLIES 80
+
+static char fen_texts[FEN_POSITIONS][FEN_MAX_LENGTH];
+static struct position fen_positions[FEN_POSITIONS];
+
+static int bench_fen(void)
+{
+    static struct undo_stack stack;
+    char buffer[FEN_MAX_LENGTH];
+    uint64_t checksum = 0;
+
+    for (int i = 0; i < FEN_POSITIONS; ++i) {
+        struct position *pos = &fen_positions[i];
+        if (position_set_fen(pos, bench_fens[i % BENCH_FEN_COUNT]) != 0) {
+            printf("Error: invalid bench FEN - %s\n", bench_fens[i % BENCH_FEN_COUNT]);
+            return -1;
+        }
+        stack.count = 0;
+        int plies = (int)(bench_random() % FEN_RANDOM_PLIES);
+        for (int ply = 0; ply < plies; ++ply) {
+            struct move_list list;
+            generate_legal_moves(pos, &list);
+            if (list.count == 0)
+                break;
+            position_make_move(pos, &stack, list.moves[bench_random() % (uint64_t)list.count]);
+        }
+        position_get_fen(pos, fen_texts[i]);
+    }
+
+    double start = now_seconds();
+    for (int round = 0; round < FEN_ROUNDS; ++round) {
+        for (int i = 0; i < FEN_POSITIONS; ++i) {
+            struct position pos;
+            position_set_fen(&pos, fen_texts[i]);
+            checksum ^= pos.key;
+        }
+    }
+    double parse_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (int round = 0; round < FEN_ROUNDS; ++round) {
+        for (int i = 0; i < FEN_POSITIONS; ++i)
+            checksum += (uint64_t)position_get_fen(&fen_positions[i], buffer);
+    }
+    double write_time = now_seconds() - start;
+
+    double count = (double)FEN_ROUNDS * FEN_POSITIONS;
+    printf("%d positions from random games\n", FEN_POSITIONS);
+    printf("parse: %8.2f M FENs/s\n", count / parse_time / 1e6);
+    printf("write: %8.2f M FENs/s\n", count / write_time / 1e6);
+    printf("checksum %llx\n", (unsigned long long)checksum);
+
+    return 0;
+}
+
+// A plain material alpha-beta is enough to exercise the staged picker:
+// every beta cutoff before the quiet stage saves a quiet generation.
+#define PICKER_DEPTH 5
+#define PICKER_INFINITE 100000
+
+static const int material_values[PIECE_TYPE_COUNT] = { 100, 320, 330, 500, 900, 0 };
+
+static struct picker_stats picker_stats;
+static move picker_killers[PICKER_DEPTH + 1][2];
+static uint64_t picker_nodes;
+
+static int material_balance(const struct position *pos)
+{
+    int score = 0;
+    for (int type = PAWN; type < KING; ++type) {
+        score += material_values[type] * (popcount(position_pieces(pos, WHITE, type))
+                                          - popcount(position_pieces(pos, BLACK, type)));
+    }
+    return pos->side_to_move == WHITE ? score : -score;
+}
+
+static int picker_alpha_beta(struct position *pos, struct undo_stack *stack, int depth, int ply, int alpha, int beta)
+{
+    picker_nodes++;
+    if (depth == 0)
+        return material_balance(pos);
+
+    struct move_picker picker;
+    move_picker_init(&picker, pos, MOVE_NONE, picker_killers[ply], NULL, &picker_stats);
+
+    int best = -PICKER_INFINITE;
+    int move_count = 0;
+    move m;
+    while ((m = move_picker_next(&picker)) != MOVE_NONE) {
+        int quiet = !move_is_noisy(pos, m);
+        move_count++;
+
+        position_make_move(pos, stack, m);
+        int score = -picker_alpha_beta(pos, stack, depth - 1, ply + 1, -beta, -alpha);
+        position_unmake_move(pos, stack, m);
+
+        if (score > best)
+            best = score;
+        if (score > alpha)
+            alpha = score;
+        if (alpha >= beta) {
+            if (quiet && picker_killers[ply][0] != m) {
+                picker_killers[ply][1] = picker_killers[ply][0];
+                picker_killers[ply][0] = m;
+            }
+            break;
+        }
+    }
+
+    if (move_count == 0)
+        return position_checkers(pos) ? -PICKER_INFINITE + ply : 0;
+
+    return best;
+}
+
+static int bench_picker(void)
+{
+    static struct undo_stack stack;
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        memset(picker_killers, 0, sizeof(picker_killers));
+        picker_alpha_beta(&pos, &stack, PICKER_DEPTH, 0, -PICKER_INFINITE, PICKER_INFINITE);
+    }
+    double elapsed = now_seconds() - start;
+
+    uint64_t avoided = picker_stats.pickers - picker_stats.quiet_generations;
+    printf("nodes %llu, %.1f K nodes/s\n", (unsigned long long)picker_nodes, picker_nodes / elapsed / 1e3);
+    printf("interior nodes %llu, quiet generation avoided at %llu (%.1f%%)\n",
+           (unsigned long long)picker_stats.pickers, (unsigned long long)avoided,
+           100.0 * (double)avoided / (double)picker_stats.pickers);
+
+    return 0;
+}
+
+#define SEE_MAX_EXCHANGES 200000
+#define SEE_ROUNDS 20
+
+struct see_sample {
+    struct position pos;
+    move capture;
+};
+
+static struct see_sample see_samples[SEE_MAX_EXCHANGES];
+static int see_sample_count;
+
+// collects the captures available in the first plies of the bench positions
+static void collect_captures(struct position *pos, struct undo_stack *stack, int depth)
+{
+    struct move_list list;
+    generate_moves(pos, &list, GEN_NOISY);
+    for (int i = 0; i < list.count && see_sample_count < SEE_MAX_EXCHANGES; ++i)
+        see_samples[see_sample_count++] = (struct see_sample){ *pos, list.moves[i] };
+
+    if (depth == 0)
+        return;
+
+    generate_legal_moves(pos, &list);
+    for (int i = 0; i < list.count; ++i) {
+        position_make_move(pos, stack, list.moves[i]);
+        collect_captures(pos, stack, depth - 1);
+        position_unmake_move(pos, stack, list.moves[i]);
+    }
+}
+
+static int bench_see(void)
+{
+    static struct undo_stack stack;
+
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        collect_captures(&pos, &stack, 2);
+    }
+
+    int64_t checksum = 0;
+    double start = now_seconds();
+    for (int round = 0; round < SEE_ROUNDS; ++round) {
+        for (int i = 0; i < see_sample_count; ++i)
+            checksum += see(&see_samples[i].pos, see_samples[i].capture);
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("%d exchanges, %.2f M exchanges/s (checksum %lld)\n", see_sample_count,
+           (double)see_sample_count * SEE_ROUNDS / elapsed / 1e6, (long long)checksum);
+
+    return 0;
+}
+
+#define ATTACK_MAP_DEPTH 3
+
+static uint64_t walk_attack_map_update(struct position *pos, struct undo_stack *stack, struct attack_map *map, int depth)
+{
+    struct move_list list;
+    generate_legal_moves(pos, &list);
+
+    uint64_t sink = 0;
+    for (int i = 0; i < list.count; ++i) {
+        position_make_move(pos, stack, list.moves[i]);
+        attack_map_update(map, pos, list.moves[i]);
+        sink += map->by_color[WHITE] ^ map->by_color[BLACK];
+        if (depth > 1)
+            sink += walk_attack_map_update(pos, stack, map, depth - 1);
+        position_unmake_move(pos, stack, list.moves[i]);
+        attack_map_update(map, pos, list.moves[i]);
+    }
+    return sink;
+}
+
+static uint64_t walk_attack_map_init(struct position *pos, struct undo_stack *stack, struct attack_map *map, int depth)
+{
+    struct move_list list;
+    generate_legal_moves(pos, &list);
+
+    uint64_t sink = 0;
+    for (int i = 0; i < list.count; ++i) {
+        position_make_move(pos, stack, list.moves[i]);
+        attack_map_init(map, pos);
+        sink += map->by_color[WHITE] ^ map->by_color[BLACK];
+        if (depth > 1)
+            sink += walk_attack_map_init(pos, stack, map, depth - 1);
+        position_unmake_move(pos, stack, list.moves[i]);
+        attack_map_init(map, pos);
+    }
+    return sink;
+}
+
+static int bench_attack_map(void)
+{
+    static struct undo_stack stack;
+    struct attack_map map;
+    uint64_t update_sink = 0, init_sink = 0;
+    double update_time = 0.0, init_time = 0.0;
+
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+
+        attack_map_init(&map, &pos);
+        double start = now_seconds();
+        update_sink += walk_attack_map_update(&pos, &stack, &map, ATTACK_MAP_DEPTH);
+        update_time += now_seconds() - start;
+
+        start = now_seconds();
+        init_sink += walk_attack_map_init(&pos, &stack, &map, ATTACK_MAP_DEPTH);
+        init_time += now_seconds() - start;
+    }
+
+    // debug builds verify every incremental update against a full rebuild
+    printf("incremental: %8.3f s\n", update_time);
+    printf("recompute:   %8.3f s\n", init_time);
+
+    if (update_sink != init_sink) {
+        printf("Error: incremental and recomputed attack maps disagree\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+#define SEARCH_DEPTH 7
+#define SEARCH_HASH_MB 16
+
+static void print_search_report(const struct search_report *report, void *context)
+{
+    (void)context;
+    search_print_report(stdout, report);
+}
+
+static int bench_search(void)
+{
+    struct search search;
+    if (search_init(&search, SEARCH_HASH_MB, print_search_report, NULL) != 0)
+        return -1;
+    tt_print_memory(stdout, &search.tt);
+
+    struct search_limits limits = { .depth = SEARCH_DEPTH };
+    struct tt_stats tt_stats = { 0 };
+    uint64_t nodes = 0;
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        printf("%s\n", bench_fens[i]);
+
+        struct search_result result = search_run(&search, &pos, NULL, &limits);
+        char uci[6];
+        move_to_uci(result.best_move, uci);
+        printf("bestmove %s\n\n", uci);
+        nodes += result.nodes;
+        tt_stats.probes += result.tt_stats.probes;
+        tt_stats.hits += result.tt_stats.hits;
+        tt_stats.collisions += result.tt_stats.collisions;
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("nodes %llu, %.1f K nodes/s\n", (unsigned long long)nodes, nodes / elapsed / 1e3);
+    printf("quiet generation avoided at %.1f%% of interior nodes\n",
+           100.0 * (double)(search.picker_stats.pickers - search.picker_stats.quiet_generations)
+               / (double)search.picker_stats.pickers);
+    printf("hash %d MB: %llu probes, %.1f%% hits, %llu collisions\n", SEARCH_HASH_MB,
+           (unsigned long long)tt_stats.probes, 100.0 * (double)tt_stats.hits / (double)tt_stats.probes,
+           (unsigned long long)tt_stats.collisions);
+
+    search_free(&search);
+    return 0;
+}
+
+#define SMP_DEPTH 8
+
+// time to reach a fixed depth on every bench position, the hash is cleared
+// before each search so all thread counts start from the same state
+static double time_to_depth(struct search *search, uint64_t *nodes)
+{
+    struct search_limits limits = { .depth = SMP_DEPTH };
+    double total = 0.0;
+    *nodes = 0;
+
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        search_clear(search);
+
+        double start = now_seconds();
+        struct search_result result = search_run(search, &pos, NULL, &limits);
+        total += now_seconds() - start;
+        *nodes += result.nodes;
+    }
+
+    return total;
+}
+
+static int bench_smp(void)
+{
+    struct search search;
+    if (search_init(&search, SEARCH_HASH_MB, NULL, NULL) != 0)
+        return -1;
+
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    double single = 0.0;
+    printf("%d NUMA node(s), topology from %s\n", node_count(), node_topology_source());
+    tt_print_memory(stdout, &search.tt);
+
+    for (int threads = 1;; threads *= 2) {
+        if (threads > cores)
+            threads = cores;
+        if (search_set_threads(&search, threads) != 0) {
+            search_free(&search);
+            return -1;
+        }
+
+        uint64_t nodes;
+        double elapsed = time_to_depth(&search, &nodes);
+        if (threads == 1)
+            single = elapsed;
+
+        printf("threads %3d: depth %d in %7.3f s, speedup %5.2f, %8.1f K nodes/s\n", threads, SMP_DEPTH,
+               elapsed, single / elapsed, nodes / elapsed / 1e3);
+
+        // per-thread node counts of the last position show the work split
+        printf("  nodes per thread:");
+        for (int i = 0; i < threads; ++i)
+            printf(" %llu", (unsigned long long)search_thread_nodes(&search, i));
+        printf("\n");
+
+        if (threads == cores)
+            break;
+    }
+
+    search_free(&search);
+    return 0;
+}
+
+// nodes to reach depth on every bench position from a cleared hash
+static uint64_t nodes_to_depth(struct search *search, int depth)
+{
+    struct search_limits limits = { .depth = depth };
+    uint64_t nodes = 0;
+
+    for (int i = 0; i < BENCH_FEN_COUNT; ++i) {
+        struct position pos;
+        position_set_fen(&pos, bench_fens[i]);
+        search_clear(search);
+        nodes += search_run(search, &pos, NULL, &limits).nodes;
+    }
+
+    return nodes;
+}
+
+// The later heuristics mostly matter deep in the tree, where the earlier
+// ones have run out of information, so besides the full-width search they
+// are also measured with all pruning on at a depth real searches reach.
+#define ORDERING_DEPTH 11
+
+static int bench_ordering(void)
+{
+    struct search search;
+    if (search_init(&search, SEARCH_HASH_MB, NULL, NULL) != 0)
+        return -1;
+
+    // the heuristics are switched on one after another
+    struct search_options all = search.options;
+    struct {
+        const char *name;
+        int *option;
+    } steps[] = {
+        { "tt move and captures", NULL },
+        { "+ killers", &search.options.killers },
+        { "+ history", &search.options.history },
+        { "+ countermoves", &search.options.countermoves },
+        { "+ continuation history", &search.options.continuation_history },
+    };
+
+    for (int pruned = 0; pruned <= 1; ++pruned) {
+        int depth = pruned ? ORDERING_DEPTH : SEARCH_DEPTH;
+        printf("%s:\n", pruned ? "with pruning" : "full width");
+
+        search.options = pruned ? all : (struct search_options){ .attack_eval = all.attack_eval };
+        for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+            if (steps[i].option)
+                *steps[i].option = 0;
+        }
+
+        uint64_t baseline = 0;
+        for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+            if (steps[i].option)
+                *steps[i].option = 1;
+
+            double start = now_seconds();
+            uint64_t nodes = nodes_to_depth(&search, depth);
+            double elapsed = now_seconds() - start;
+            if (i == 0)
+                baseline = nodes;
+
+            printf("%-24s depth %2d: %10llu nodes, %5.1f%% of baseline, %7.3f s\n", steps[i].name, depth,
+                   (unsigned long long)nodes, 100.0 * (double)nodes / (double)baseline, elapsed);
+        }
+    }
+    search.options = all;
+
+    search_free(&search);
+    return 0;
+}
+
+static int bench_pruning(void)
+{
+    struct search search;
+    if (search_init(&search, SEARCH_HASH_MB, NULL, NULL) != 0)
+        return -1;
+
+    // every technique on its own against a full-width search with the
+    // complete move ordering, then all of them together
+    struct search_options all = search.options;
+    struct search_options full_width = all;
+    full_width.null_move = 0;
+    full_width.late_move_reductions = 0;
+    full_width.reverse_futility = 0;
+    full_width.futility = 0;
+    full_width.singular_extensions = 0;
+
+    struct {
+        const char *name;
+        int *option;
+    } steps[] = {
+        { "full width", NULL },
+        { "null move", &search.options.null_move },
+        { "late move reductions", &search.options.late_move_reductions },
+        { "reverse futility", &search.options.reverse_futility },
+        { "futility", &search.options.futility },
+        { "singular extensions", &search.options.singular_extensions },
+    };
+
+    uint64_t baseline = 0;
+    for (size_t i = 0; i <= sizeof(steps) / sizeof(steps[0]); ++i) {
+        const char *name = "all";
+        search.options = all;
+        if (i < sizeof(steps) / sizeof(steps[0])) {
+            name = steps[i].name;
+            search.options = full_width;
+            if (steps[i].option)
+                *steps[i].option = 1;
+        }
+
+        double start = now_seconds();
+        uint64_t nodes = nodes_to_depth(&search, SEARCH_DEPTH);
+        double elapsed = now_seconds() - start;
+        if (i == 0)
+            baseline = nodes;
+
+        printf("%-24s depth %d: %10llu nodes, %5.1f%% of baseline, %7.3f s\n", name, SEARCH_DEPTH,
+               (unsigned long long)nodes, 100.0 * (double)nodes / (double)baseline, elapsed);
+    }
+    search.options = all;
+
+    search_free(&search);
+    return 0;
+}
+
+// Search signature: the total node count of fixed depth searches with one
+// thread, a fixed hash and everything cleared before each position is fully
+// deterministic. Any change to search behaviour changes it, a speedup only
+// changes the nodes per second.
+#define SIGNATURE_DEPTH 11
+#define SIGNATURE_HASH_MB 16
+
+static const char *signature_fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/2pb1ppp/2pp1q2/p7/1nP1B3/1P2P3/P2N1PPP/R2QK2R w KQkq a6 0 14",
+    "4rrk1/2p1b1p1/p1p3q1/4p3/2P2n1p/1P1NR2P/PB3PP1/3R1QK1 b - - 2 24",
+    "r3qbrk/6p1/2b2pPp/p3pP1Q/PpPpP2P/3P1B2/2PB3K/R5R1 w - - 16 42",
+    "6k1/1R3p2/6p1/2Bp3p/3P2q1/P7/1P2rQ1K/5R2 b - - 4 44",
+    "8/8/1p2k1p1/3p3p/1p1P1P1P/1P2PK2/8/8 w - - 3 54",
+    "7r/2p3k1/1p1p1qp1/1P1Bp3/p1P2r1P/P7/4R3/Q4RK1 w - - 0 36",
+    "r1bq1rk1/pp2b1pp/n1pp1n2/3P1p2/2P1p3/2N1P2N/PP2BPPP/R1BQ1RK1 b - - 2 10",
+    "3r3k/2r4p/1p1b3q/p4P2/P2Pp3/1B2P3/3BQ1RP/6K1 w - - 3 87",
+    "2r4r/1p4k1/1Pnp4/3Qb1pq/8/4BpPp/5P2/2RR1BK1 w - - 0 42",
+    "4q1bk/6b1/7p/p1p4p/PNPpP2P/KN4P1/3Q4/4R3 b - - 0 37",
+    "2q3r1/1r2pk2/pp3pp1/2pP3p/P1Pb1BbP/1P4Q1/R3NPP1/4R1K1 w - - 2 34",
+    "1r2r2k/1b4q1/pp5p/2pPp1p1/P3Pn2/1P1B1Q1P/2R3P1/4BR1K b - - 1 37",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+    "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+};
+
+#define SIGNATURE_FEN_COUNT (int)(sizeof(signature_fens) / sizeof(signature_fens[0]))
+
+static int bench_signature(void)
+{
+    struct search search;
+    if (search_init(&search, SIGNATURE_HASH_MB, NULL, NULL) != 0)
+        return -1;
+
+    struct search_limits limits = { .depth = SIGNATURE_DEPTH };
+    uint64_t nodes = 0;
+    double elapsed = 0.0;
+
+    for (int i = 0; i < SIGNATURE_FEN_COUNT; ++i) {
+        struct position pos;
+        if (position_set_fen(&pos, signature_fens[i]) != 0) {
+            printf("Error: invalid FEN - %s\n", signature_fens[i]);
+            search_free(&search);
+            return -1;
+        }
+        search_clear(&search);
+
+        double start = now_seconds();
+        struct search_result result = search_run(&search, &pos, NULL, &limits);
+        double seconds = now_seconds() - start;
+        nodes += result.nodes;
+        elapsed += seconds;
+
+        char uci[6];
+        move_to_uci(result.best_move, uci);
+        printf("position %2d: bestmove %-5s score %6d nodes %10llu %7.3f s\n", i + 1, uci, result.score,
+               (unsigned long long)result.nodes, seconds);
+    }
+
+    printf("depth %d, %d positions, 1 thread, %d MB hash\n", SIGNATURE_DEPTH, SIGNATURE_FEN_COUNT,
+           SIGNATURE_HASH_MB);
+    printf("nodes %llu\n", (unsigned long long)nodes);
+    printf("nps %.0f\n", nodes / elapsed);
+
+    search_free(&search);
+    return 0;
+}
+
+struct bench_mode {
+    const char *name;
+    const char *description;
+    int (*run)(void);
+};
+
+static const struct bench_mode modes[] = {
+    { "attacks",   "sliding attack lookups per second (magic and pext)", bench_attacks },
+    { "makemove",  "make/unmake against copy-make moves per second", bench_make_move },
+    { "fen",       "FEN strings parsed and written per second", bench_fen },
+    { "picker",    "staged move picker in a material alpha-beta, quiet generations avoided", bench_picker },
+    { "see",       "static exchange evaluations per second", bench_see },
+    { "attackmap", "incremental attack map updates against full recomputation", bench_attack_map },
+    { "search",    "iterative deepening search of the bench positions", bench_search },
+    { "smp",       "Lazy SMP time-to-depth speedup from 1 thread to all cores", bench_smp },
+    { "ordering",  "nodes to depth as each move ordering heuristic is enabled", bench_ordering },
+    { "pruning",   "nodes to depth with each pruning, reduction and extension alone", bench_pruning },
+    { "bench",     "deterministic node count signature and nodes per second", bench_signature },
+};
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s <mode>\n", program);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+        printf("  %-10s %s\n", modes[i].name, modes[i].description);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    attacks_init();
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        if (strcmp(argv[1], modes[i].name) == 0)
+            return modes[i].run();
+    }
+
+    print_usage(argv[0]);
+    return -1;
+}
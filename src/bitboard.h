@@ -0,0 +1,49 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+// A bitboard is a 64 bit set of squares where bit 0 is a1 and bit 63 is h8.
+
+#define FILE_A_BB 0x0101010101010101ULL
+#define FILE_H_BB 0x8080808080808080ULL
+#define RANK_1_BB 0x00000000000000FFULL
+#define RANK_8_BB 0xFF00000000000000ULL
+
+static inline uint64_t square_bb(int square)
+{
+    return 1ULL << square;
+}
+
+static inline int popcount(uint64_t bb)
+{
+#if defined(__POPCNT__) || !defined(__x86_64__)
+    return __builtin_popcountll(bb);
+#else
+    // without -mpopcnt the builtin is a library call, this stays inline
+    bb -= (bb >> 1) & 0x5555555555555555ULL;
+    bb = (bb & 0x3333333333333333ULL) + ((bb >> 2) & 0x3333333333333333ULL);
+    bb = (bb + (bb >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((bb * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline int lsb(uint64_t bb)
+{
+    return __builtin_ctzll(bb);
+}
+
+// returns the lowest square and removes it from the set
+static inline int pop_lsb(uint64_t *bb)
+{
+    int square = __builtin_ctzll(*bb);
+    *bb &= *bb - 1;
+    return square;
+}
+
+static inline int more_than_one(uint64_t bb)
+{
+    return (bb & (bb - 1)) != 0;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "draw.h"
+
+#include "bitboard.h"
+
+#define DARK_SQUARES 0xAA55AA55AA55AA55ULL
+
+int key_history_repetitions(const struct key_history *history, uint64_t key, int window)
+{
+    if (window > (int)history->count)
+        window = (int)history->count;
+    if (window > KEY_HISTORY_SIZE)
+        window = KEY_HISTORY_SIZE;
+
+    // the side to move matches every second ply, and a position can't recur
+    // in fewer than four
+    int repetitions = 0;
+    for (int ply = 4; ply <= window; ply += 2) {
+        if (history->keys[(history->count - (uint32_t)ply) % KEY_HISTORY_SIZE] == key)
+            repetitions++;
+    }
+    return repetitions;
+}
+
+int position_insufficient_material(const struct position *pos)
+{
+    if (pos->pieces[PAWN] | pos->pieces[ROOK] | pos->pieces[QUEEN])
+        return 0;
+
+    uint64_t minors = pos->pieces[KNIGHT] | pos->pieces[BISHOP];
+    if (!more_than_one(minors))
+        return 1;
+
+    // any number of bishops that all stand on the same square colour
+    if (pos->pieces[KNIGHT])
+        return 0;
+    return !(minors & DARK_SQUARES) || !(minors & ~DARK_SQUARES);
+}
+
+enum draw_reason position_draw_state(const struct position *pos, const struct key_history *history, int repetitions)
+{
+    if (pos->halfmove_clock >= 100)
+        return DRAW_FIFTY_MOVES;
+    if (key_history_repetitions(history, pos->key, pos->halfmove_clock) >= repetitions)
+        return DRAW_REPETITION;
+    if (position_insufficient_material(pos))
+        return DRAW_INSUFFICIENT_MATERIAL;
+    return DRAW_NONE;
+}
+
+const char *draw_reason_name(enum draw_reason reason)
+{
+    switch (reason) {
+    case DRAW_REPETITION:            return "repetition";
+    case DRAW_FIFTY_MOVES:           return "fifty-move rule";
+    case DRAW_INSUFFICIENT_MATERIAL: return "insufficient material";
+    default:                         return "none";
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef DRAW_H
+#define DRAW_H
+
+#include <stdint.h>
+
+#include "position.h"
+
+// Zobrist keys of the positions played before the current one. Only the
+// last KEY_HISTORY_SIZE keys are kept, which covers the longest reversible
+// window the fifty-move rule allows.
+#define KEY_HISTORY_SIZE 256
+
+struct key_history {
+    uint32_t count;
+    uint64_t keys[KEY_HISTORY_SIZE];
+};
+
+enum draw_reason {
+    DRAW_NONE,
+    DRAW_REPETITION,
+    DRAW_FIFTY_MOVES,
+    DRAW_INSUFFICIENT_MATERIAL,
+};
+
+static inline void key_history_clear(struct key_history *history)
+{
+    history->count = 0;
+}
+
+// push the key of the position a move is about to be made from
+static inline void key_history_push(struct key_history *history, uint64_t key)
+{
+    history->keys[history->count++ % KEY_HISTORY_SIZE] = key;
+}
+
+static inline void key_history_pop(struct key_history *history)
+{
+    history->count--;
+}
+
+// How often key occurred with the same side to move among the last window
+// plies. Pass the halfmove clock as the window: an irreversible move ends it.
+int key_history_repetitions(const struct key_history *history, uint64_t key, int window);
+
+int position_insufficient_material(const struct position *pos);
+
+// Checks the draw rules for pos, repetitions is the number of earlier
+// occurrences that count as a draw: 2 for the threefold rule in a game, 1
+// inside a search. Checkmate on the move that reaches the fifty-move limit
+// takes precedence, callers with a move list have to check that themselves.
+enum draw_reason position_draw_state(const struct position *pos, const struct key_history *history, int repetitions);
+
+const char *draw_reason_name(enum draw_reason reason);
+
+#endif
@@ -0,0 +1,210 @@
+#include "engine.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define COMMAND_CAPACITY 16
+#define EVENT_CAPACITY   256
+
+// Call after anything a waiter may be waiting for: a push or pop on a queue
+// or quitting. The fence pairs with the one in wait_until(), either the
+// waiter's check sees the change or this sees the waiter.
+static void wake(struct engine *engine)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&engine->waiters, memory_order_relaxed) == 0)
+        return;
+
+    pthread_mutex_lock(&engine->lock);
+    pthread_cond_broadcast(&engine->wakeup);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+// blocks until done returns nonzero, done is retried after every wake()
+static void wait_until(struct engine *engine, int (*done)(struct engine *engine, void *arg), void *arg)
+{
+    if (done(engine, arg))
+        return;
+
+    pthread_mutex_lock(&engine->lock);
+    atomic_fetch_add(&engine->waiters, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!done(engine, arg))
+        pthread_cond_wait(&engine->wakeup, &engine->lock);
+    atomic_fetch_sub(&engine->waiters, 1);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+static int pop_command(struct engine *engine, void *command)
+{
+    return spsc_pop(&engine->commands, command);
+}
+
+static int push_command(struct engine *engine, void *command)
+{
+    return spsc_push(&engine->commands, command) == 0;
+}
+
+// gives up once the engine is quitting, nobody will read the event then
+static int push_event(struct engine *engine, void *event)
+{
+    return spsc_push(&engine->events, event) == 0 || atomic_load(&engine->quitting);
+}
+
+static int cancelled(struct engine *engine, unsigned id)
+{
+    return (int)(atomic_load(&engine->cancel_id) - id) >= 0;
+}
+
+// Called from the search the worker runs. A cancel or a ponder hit only
+// applies to the search it was meant for, including one that arrived
+// before that search started.
+static void poll_commands(void *context)
+{
+    struct engine *engine = context;
+
+    if (cancelled(engine, engine->searching_id))
+        search_stop(&engine->search);
+    if (atomic_load(&engine->ponderhit_id) == engine->searching_id && atomic_load(&engine->search.pondering))
+        search_ponderhit(&engine->search);
+}
+
+// runs on the worker, called after every completed iteration
+static void report_iteration(const struct search_report *report, void *context)
+{
+    struct engine *engine = context;
+
+    poll_commands(engine);
+
+    struct engine_event event = { .type = ENGINE_INFO, .id = engine->searching_id, .report = *report };
+    spsc_push(&engine->events, &event);
+}
+
+static void *engine_main(void *arg)
+{
+    struct engine *engine = arg;
+    struct engine_command command;
+
+    for (;;) {
+        wait_until(engine, pop_command, &command);
+        // engine_quit() may be waiting for the slot
+        wake(engine);
+
+        if (command.type == ENGINE_QUIT)
+            break;
+
+        if (command.type == ENGINE_NEW_GAME) {
+            search_clear(&engine->search);
+            continue;
+        }
+
+        struct engine_event event = { .type = ENGINE_BEST_MOVE, .id = command.id };
+        engine->searching_id = command.id;
+        if (!cancelled(engine, command.id))
+            event.result = search_run(&engine->search, &command.pos, &command.history, &command.limits);
+
+        // the best move must not be lost, wait for the caller to drain events
+        wait_until(engine, push_event, &event);
+    }
+
+    return NULL;
+}
+
+int engine_start(struct engine *engine, size_t hash_mb, int threads)
+{
+    memset(engine, 0, sizeof(*engine));
+
+    if (search_init(&engine->search, hash_mb, report_iteration, engine) != 0)
+        return -1;
+    engine->search.poll = poll_commands;
+    if (search_set_threads(&engine->search, threads) != 0
+        || spsc_init(&engine->commands, COMMAND_CAPACITY, sizeof(struct engine_command)) != 0
+        || spsc_init(&engine->events, EVENT_CAPACITY, sizeof(struct engine_event)) != 0) {
+        spsc_free(&engine->commands);
+        search_free(&engine->search);
+        return -1;
+    }
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->wakeup, NULL);
+    atomic_init(&engine->waiters, 0);
+
+    if (pthread_create(&engine->thread, NULL, engine_main, engine) != 0) {
+        printf("Error: failed to start the engine thread\n");
+        pthread_cond_destroy(&engine->wakeup);
+        pthread_mutex_destroy(&engine->lock);
+        spsc_free(&engine->events);
+        spsc_free(&engine->commands);
+        search_free(&engine->search);
+        return -1;
+    }
+
+    return 0;
+}
+
+void engine_quit(struct engine *engine)
+{
+    atomic_store(&engine->quitting, 1);
+    engine_stop(engine);
+    wake(engine);
+
+    struct engine_command command = { .type = ENGINE_QUIT };
+    wait_until(engine, push_command, &command);
+    wake(engine);
+    pthread_join(engine->thread, NULL);
+
+    spsc_free(&engine->events);
+    spsc_free(&engine->commands);
+    search_free(&engine->search);
+    pthread_cond_destroy(&engine->wakeup);
+    pthread_mutex_destroy(&engine->lock);
+}
+
+unsigned engine_go(struct engine *engine, const struct position *pos, const struct key_history *history,
+                   const struct search_limits *limits)
+{
+    struct engine_command command;
+    command.type = ENGINE_GO;
+    command.id = engine->last_id + 1;
+    command.pos = *pos;
+    if (history)
+        command.history = *history;
+    else
+        key_history_clear(&command.history);
+    command.limits = *limits;
+
+    if (spsc_push(&engine->commands, &command) != 0)
+        return 0;
+    wake(engine);
+
+    engine->last_id = command.id;
+    return command.id;
+}
+
+void engine_stop(struct engine *engine)
+{
+    atomic_store(&engine->cancel_id, engine->last_id);
+    search_stop(&engine->search);
+}
+
+void engine_ponderhit(struct engine *engine, unsigned id)
+{
+    // the worker applies it, the search running right now may be another one
+    atomic_store(&engine->ponderhit_id, id);
+}
+
+void engine_new_game(struct engine *engine)
+{
+    struct engine_command command = { .type = ENGINE_NEW_GAME };
+    if (spsc_push(&engine->commands, &command) == 0)
+        wake(engine);
+}
+
+int engine_poll(struct engine *engine, struct engine_event *event)
+{
+    if (!spsc_pop(&engine->events, event))
+        return 0;
+    // the worker may be waiting to hand over a best move
+    wake(engine);
+    return 1;
+}
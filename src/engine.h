@@ -0,0 +1,89 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "draw.h"
+#include "position.h"
+#include "search.h"
+#include "spsc_queue.h"
+
+// The engine searches on its own worker thread so the caller, typically the
+// render loop, never waits for it. Searches are requested through a command
+// queue and their progress comes back through an event queue; both are
+// lock-free single-producer single-consumer rings. All engine_* functions
+// except engine_start must be called from the one thread that started it.
+
+enum engine_command_type {
+    ENGINE_GO,
+    ENGINE_NEW_GAME,
+    ENGINE_QUIT
+};
+
+struct engine_command {
+    enum engine_command_type type;
+    unsigned id;
+    struct position pos;
+    struct key_history history;
+    struct search_limits limits;
+};
+
+enum engine_event_type {
+    ENGINE_INFO,       // one completed iteration, dropped if the queue is full
+    ENGINE_BEST_MOVE   // the search with this id is over
+};
+
+struct engine_event {
+    enum engine_event_type type;
+    unsigned id;
+    struct search_report report;
+    struct search_result result;
+};
+
+struct engine {
+    pthread_t thread;
+    struct search search;
+    struct spsc_queue commands;
+    struct spsc_queue events;
+    unsigned last_id;
+    _Atomic unsigned cancel_id;  // every search up to this id is cancelled
+    _Atomic unsigned ponderhit_id;
+    _Atomic int quitting;
+    unsigned searching_id;       // worker side
+
+    // Only for sleeping and waking, the queues never take the lock. A side
+    // that finds a queue empty or full counts itself in waiters and waits
+    // on wakeup, the other side signals when it sees a waiter.
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    _Atomic int waiters;
+};
+
+// returns -1 if the search, the queues or the thread can't be created
+int engine_start(struct engine *engine, size_t hash_mb, int threads);
+
+// stops any search, joins the worker and frees everything
+void engine_quit(struct engine *engine);
+
+// Queues a search, returns its id or 0 if the command queue is full. The
+// result arrives as an ENGINE_BEST_MOVE event with the same id.
+unsigned engine_go(struct engine *engine, const struct position *pos, const struct key_history *history,
+                   const struct search_limits *limits);
+
+// cancels every search queued so far, each still reports a best move
+void engine_stop(struct engine *engine);
+
+// Turns the ponder search id into a normal timed search, call it when the
+// opponent played the move it was started for. On any other move use
+// engine_stop(): the search ends at once and what it stored in the
+// transposition table helps the next one.
+void engine_ponderhit(struct engine *engine, unsigned id);
+
+// clears the hash and heuristics before the next search
+void engine_new_game(struct engine *engine);
+
+// never blocks, returns 1 if an event was copied to event
+int engine_poll(struct engine *engine, struct engine_event *event);
+
+#endif
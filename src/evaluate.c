@@ -0,0 +1,180 @@
+#include "evaluate.h"
+
+#include "bitboard.h"
+
+static const int piece_values[PIECE_TYPE_COUNT] = { 100, 320, 330, 500, 900, 0 };
+
+// Tables are written from white's side with rank 8 on top, so white looks
+// up square ^ 56 and black uses the square as is.
+static const int pst_middlegame[PIECE_TYPE_COUNT][64] = {
+    [PAWN] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         10,  10,  20,  30,  30,  20,  10,  10,
+          5,   5,  10,  25,  25,  10,   5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    },
+    [KNIGHT] = {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50,
+    },
+    [BISHOP] = {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20,
+    },
+    [ROOK] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10,  10,  10,  10,  10,   5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          0,   0,   0,   5,   5,   0,   0,   0,
+    },
+    [QUEEN] = {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    },
+    [KING] = {
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+         20,  20,   0,   0,   0,   0,  20,  20,
+         20,  30,  10,   0,   0,  10,  30,  20,
+    },
+};
+
+// only pawns and the king change their preferences in the endgame
+static const int pst_endgame_pawn[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int pst_endgame_king[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+// phase weights of the non-pawn pieces, 24 with all of them on the board
+static const int phase_weights[PIECE_TYPE_COUNT] = { 0, 1, 1, 2, 4, 0 };
+#define PHASE_MAX 24
+
+// per safe square a piece attacks, counted from the typical number so that
+// an average piece keeps its table value
+static const int mobility_middlegame[PIECE_TYPE_COUNT] = { 0, 4, 5, 2, 1, 0 };
+static const int mobility_endgame[PIECE_TYPE_COUNT] = { 0, 4, 5, 4, 2, 0 };
+static const int mobility_typical[PIECE_TYPE_COUNT] = { 0, 4, 6, 7, 13, 0 };
+
+// pieces attacked by an enemy pawn or attacked and not defended at all
+#define PAWN_THREAT_MIDDLEGAME 40
+#define PAWN_THREAT_ENDGAME 30
+#define HANGING_MIDDLEGAME 20
+#define HANGING_ENDGAME 10
+
+static uint64_t pawn_attacks_bb(uint64_t pawns, int color)
+{
+    if (color == WHITE)
+        return ((pawns << 7) & ~FILE_H_BB) | ((pawns << 9) & ~FILE_A_BB);
+    return ((pawns >> 9) & ~FILE_H_BB) | ((pawns >> 7) & ~FILE_A_BB);
+}
+
+// mobility and threats of one side, sign as in evaluate()
+static void evaluate_attacks(const struct position *pos, const struct attack_map *map, int color, int sign, int *mg,
+                             int *eg)
+{
+    int them = color ^ 1;
+    uint64_t own = pos->colors[color];
+    uint64_t enemy_pawn_attacks = pawn_attacks_bb(position_pieces(pos, them, PAWN), them);
+    uint64_t safe = ~own & ~enemy_pawn_attacks;
+
+    for (int type = KNIGHT; type <= QUEEN; ++type) {
+        for (uint64_t pieces = position_pieces(pos, color, type); pieces;) {
+            int count = popcount(map->attacks_from[pop_lsb(&pieces)] & safe) - mobility_typical[type];
+            *mg += sign * mobility_middlegame[type] * count;
+            *eg += sign * mobility_endgame[type] * count;
+        }
+    }
+
+    uint64_t not_king = own & ~position_pieces(pos, color, KING);
+    int pawn_threats = popcount(not_king & ~position_pieces(pos, color, PAWN) & enemy_pawn_attacks);
+    int hanging = popcount(not_king & map->by_color[them] & ~map->by_color[color]);
+    *mg -= sign * (PAWN_THREAT_MIDDLEGAME * pawn_threats + HANGING_MIDDLEGAME * hanging);
+    *eg -= sign * (PAWN_THREAT_ENDGAME * pawn_threats + HANGING_ENDGAME * hanging);
+}
+
+int evaluate(const struct position *pos, const struct attack_map *map)
+{
+    int middlegame = 0, endgame = 0, phase = 0;
+
+    for (int color = WHITE; color <= BLACK; ++color) {
+        int sign = color == WHITE ? 1 : -1;
+        int flip = color == WHITE ? 56 : 0;
+
+        for (int type = PAWN; type <= KING; ++type) {
+            uint64_t pieces = position_pieces(pos, color, type);
+            phase += phase_weights[type] * popcount(pieces);
+
+            while (pieces) {
+                int square = pop_lsb(&pieces) ^ flip;
+                int mg = piece_values[type] + pst_middlegame[type][square];
+                int eg = piece_values[type];
+
+                if (type == PAWN)
+                    eg += pst_endgame_pawn[square];
+                else if (type == KING)
+                    eg += pst_endgame_king[square];
+                else
+                    eg += pst_middlegame[type][square];
+
+                middlegame += sign * mg;
+                endgame += sign * eg;
+            }
+        }
+
+        if (map)
+            evaluate_attacks(pos, map, color, sign, &middlegame, &endgame);
+    }
+
+    if (phase > PHASE_MAX)
+        phase = PHASE_MAX;
+    int score = (middlegame * phase + endgame * (PHASE_MAX - phase)) / PHASE_MAX;
+
+    return pos->side_to_move == WHITE ? score : -score;
+}
@@ -0,0 +1,13 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "attack_map.h"
+#include "position.h"
+
+// Material plus piece-square tables, tapered between middlegame and
+// endgame by the remaining non-pawn material. With an attack map for pos
+// it adds mobility and threats read from it, map may be NULL to leave
+// those out. Returns centipawns from the point of view of the side to move.
+int evaluate(const struct position *pos, const struct attack_map *map);
+
+#endif
@@ -0,0 +1,380 @@
+#include "fen.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "attacks.h"
+
+static const char piece_chars[PIECE_COUNT + 1] = " PNBRQK  pnbrqk ";
+
+// What a placement character does, packed so one load fetches it all: the
+// piece in bits 0-7, the slots to advance in bits 8-15 and bit 16 for a
+// digit. A piece fills one slot, a digit skips as many empty ones and a
+// slash fills the ninth slot of its rank. The advance is stored xor'ed with
+// PLACEMENT_END, so the zero entry of every other character, the space and
+// the terminator included, jumps past the end and stops the loop.
+#define PLACEMENT_END 0x80
+#define PLACEMENT_DIGIT (1u << 16)
+#define SLASH_SLOT 0x10
+
+#define PIECE_CHAR(p) ((uint32_t)(p) | (1u ^ PLACEMENT_END) << 8)
+#define DIGIT_CHAR(n) (((uint32_t)(n) ^ PLACEMENT_END) << 8 | PLACEMENT_DIGIT)
+
+static const uint32_t placement_chars[256] = {
+    ['P'] = PIECE_CHAR(WHITE_PAWN), ['N'] = PIECE_CHAR(WHITE_KNIGHT), ['B'] = PIECE_CHAR(WHITE_BISHOP),
+    ['R'] = PIECE_CHAR(WHITE_ROOK), ['Q'] = PIECE_CHAR(WHITE_QUEEN),  ['K'] = PIECE_CHAR(WHITE_KING),
+    ['p'] = PIECE_CHAR(BLACK_PAWN), ['n'] = PIECE_CHAR(BLACK_KNIGHT), ['b'] = PIECE_CHAR(BLACK_BISHOP),
+    ['r'] = PIECE_CHAR(BLACK_ROOK), ['q'] = PIECE_CHAR(BLACK_QUEEN),  ['k'] = PIECE_CHAR(BLACK_KING),
+    ['1'] = DIGIT_CHAR(1), ['2'] = DIGIT_CHAR(2), ['3'] = DIGIT_CHAR(3), ['4'] = DIGIT_CHAR(4),
+    ['5'] = DIGIT_CHAR(5), ['6'] = DIGIT_CHAR(6), ['7'] = DIGIT_CHAR(7), ['8'] = DIGIT_CHAR(8),
+    ['/'] = PIECE_CHAR(SLASH_SLOT),
+};
+
+// Reads the placement field into squares in FEN order, a8 first, and
+// returns the character after it or NULL if the field is malformed. The
+// ranks are laid out nine slots apart, so a slash lands in the ninth slot
+// of its rank exactly when the rank before it was complete. That leaves a
+// load, a store and an add per character, everything is checked once at
+// the end.
+static const char *parse_placement(const char *fen, uint8_t squares[64])
+{
+    uint8_t slots[8 * 9] = { 0 };
+    int index = 0;
+    uint32_t previous = 0;
+    uint32_t digits = 0;
+
+    do {
+        uint32_t pc = placement_chars[(unsigned char)*fen++];
+        digits |= pc & previous;  // two digits in a row
+        previous = pc;
+        slots[index] = (uint8_t)pc;
+        index += (int)((pc >> 8 & 0xFF) ^ PLACEMENT_END);
+    } while (index < 8 * 9);
+
+    // the last rank is complete and a space stopped the loop
+    if (index != 8 * 9 - 1 + PLACEMENT_END || fen[-1] != ' ' || (digits & PLACEMENT_DIGIT))
+        return NULL;
+    for (int rank = 0; rank < 8; ++rank) {
+        uint64_t rank_squares;
+        memcpy(&rank_squares, slots + rank * 9, 8);
+        // a slash that ended a short rank is on a square instead
+        if ((rank_squares & 0x1010101010101010ULL) || (rank < 7 && slots[rank * 9 + 8] != SLASH_SLOT))
+            return NULL;
+        memcpy(squares + rank * 8, &rank_squares, 8);
+    }
+
+    return fen;
+}
+
+// Bitboards from the FEN ordered squares. A square's FEN index is the
+// square with the rank flipped, so a mask in FEN order becomes a bitboard
+// by reversing its bytes.
+static void placement_bitboards(const uint8_t squares[64], uint64_t pieces[PIECE_TYPE_COUNT], uint64_t colors[2])
+{
+#if defined(__SSE2__)
+    __m128i chunks[4];
+    for (int i = 0; i < 4; ++i)
+        chunks[i] = _mm_loadu_si128((const __m128i *)(squares + 16 * i));
+
+    // piece type + 1 in the low three bits, the colour in bit 3
+    uint64_t occupied = 0, black = 0;
+    for (int i = 0; i < 4; ++i) {
+        occupied |= (uint64_t)(uint16_t)~_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], _mm_setzero_si128())) << (16 * i);
+        black |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_slli_epi16(chunks[i], 4)) << (16 * i);
+    }
+    for (int type = 0; type < PIECE_TYPE_COUNT; ++type) {
+        __m128i value = _mm_set1_epi8((char)(type + 1));
+        uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i types = _mm_and_si128(chunks[i], _mm_set1_epi8(7));
+            mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(types, value)) << (16 * i);
+        }
+        pieces[type] = __builtin_bswap64(mask);
+    }
+    colors[WHITE] = __builtin_bswap64(occupied & ~black);
+    colors[BLACK] = __builtin_bswap64(occupied & black);
+#else
+    memset(pieces, 0, PIECE_TYPE_COUNT * sizeof(*pieces));
+    colors[WHITE] = colors[BLACK] = 0;
+    for (int index = 0; index < 64; ++index) {
+        int piece = squares[index];
+        if (piece == NO_PIECE)
+            continue;
+        pieces[piece_type(piece)] |= square_bb(index ^ 56);
+        colors[piece_color(piece)] |= square_bb(index ^ 56);
+    }
+#endif
+}
+
+// the mailbox packs two squares per byte, even squares in the low nibble
+static void placement_mailbox(const uint8_t squares[64], uint8_t board[32])
+{
+#if defined(__SSE2__)
+    // a FEN ordered chunk holds two ranks, the higher one first
+    for (int i = 0; i < 4; i += 2) {
+        __m128i packed[2];
+        for (int j = 0; j < 2; ++j) {
+            __m128i pairs = _mm_loadu_si128((const __m128i *)(squares + 16 * (i + j)));
+            packed[j] = _mm_and_si128(_mm_or_si128(pairs, _mm_srli_epi16(pairs, 4)), _mm_set1_epi16(0xFF));
+        }
+        // four ranks of four bytes, reversed into square order
+        __m128i ranks = _mm_shuffle_epi32(_mm_packus_epi16(packed[0], packed[1]), _MM_SHUFFLE(0, 1, 2, 3));
+        _mm_storeu_si128((__m128i *)(board + 16 - 8 * i), ranks);
+    }
+#else
+    for (int square = 0; square < 64; square += 2)
+        board[square >> 1] = (uint8_t)(squares[square ^ 56] | squares[(square ^ 56) + 1] << 4);
+#endif
+}
+
+static int parse_number(const char **text, int max)
+{
+    const char *s = *text;
+    int value = 0;
+
+    if (*s < '0' || *s > '9')
+        return -1;
+    do {
+        value = value * 10 + (*s++ - '0');
+        if (value > max)
+            return -1;
+    } while (*s >= '0' && *s <= '9');
+
+    *text = s;
+    return value;
+}
+
+// Every castling right needs its king and rook on their original squares,
+// checked for all rights at once: which rights are set differs from one
+// position to the next and would be hard to predict right by right.
+static int castling_consistent(int rights, const uint64_t pieces[PIECE_TYPE_COUNT], const uint64_t colors[2])
+{
+    uint64_t kings = (rights & (CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN) ? square_bb(E1) : 0)
+                   | (rights & (CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN) ? square_bb(E8) : 0);
+    uint64_t rooks = (rights & CASTLE_WHITE_KING ? square_bb(H1) : 0) | (rights & CASTLE_WHITE_QUEEN ? square_bb(A1) : 0)
+                   | (rights & CASTLE_BLACK_KING ? square_bb(H8) : 0) | (rights & CASTLE_BLACK_QUEEN ? square_bb(A8) : 0);
+    uint64_t own_back_ranks = (colors[WHITE] & RANK_1_BB) | (colors[BLACK] & RANK_8_BB);
+    return !(kings & ~(pieces[KING] & own_back_ranks)) && !(rooks & ~(pieces[ROOK] & own_back_ranks));
+}
+
+// Castling rights in KQkq order, or '-'. The four characters are looked at
+// without branching on them: each one only counts if it comes after the one
+// before in that order, and the read stops at the first that doesn't.
+static const uint8_t castling_chars[256] = {
+    ['K'] = CASTLE_WHITE_KING, ['Q'] = CASTLE_WHITE_QUEEN, ['k'] = CASTLE_BLACK_KING, ['q'] = CASTLE_BLACK_QUEEN,
+};
+
+static const char *parse_castling(const char *fen, int *rights)
+{
+    if (*fen == '-') {
+        *rights = 0;
+        return fen + 1;
+    }
+
+    int result = 0;
+    int length = 0;
+    for (int i = 0; i < 4; ++i) {
+        int right = castling_chars[(unsigned char)fen[length]];
+        int next = right > result;  // right is a higher bit than all before
+        result |= next ? right : 0;
+        length += next;
+    }
+
+    *rights = result;
+    return length ? fen + length : NULL;
+}
+
+int position_set_fen(struct position *pos, const char *fen)
+{
+    // The placement is read into a byte per square without branching on
+    // the characters, bitboards, mailbox and key are derived from that in
+    // bulk. A branch per character mispredicts all the time once the
+    // positions differ from one call to the next.
+    uint8_t squares[64];
+    fen = parse_placement(fen, squares);
+    if (!fen)
+        return -1;
+
+    uint64_t pieces[PIECE_TYPE_COUNT];
+    uint64_t colors[2];
+    placement_bitboards(squares, pieces, colors);
+
+    // one king each and no pawns on the back ranks, before anything is
+    // looked up by king square
+    uint64_t white_king = pieces[KING] & colors[WHITE];
+    uint64_t black_king = pieces[KING] & colors[BLACK];
+    if (!white_king || more_than_one(white_king) || !black_king || more_than_one(black_king))
+        return -1;
+    if (pieces[PAWN] & (RANK_1_BB | RANK_8_BB))
+        return -1;
+
+    memcpy(pos->pieces, pieces, sizeof(pieces));
+    memcpy(pos->colors, colors, sizeof(colors));
+    placement_mailbox(squares, pos->board);
+    pos->en_passant = NO_SQUARE;
+    pos->halfmove_clock = 0;
+    pos->fullmove_number = 1;
+
+    if (*fen != 'w' && *fen != 'b')
+        return -1;
+    int us = *fen++ == 'w' ? WHITE : BLACK;
+    int them = us ^ 1;
+    pos->side_to_move = (uint8_t)us;
+    if (*fen++ != ' ')
+        return -1;
+
+    int castling_rights;
+    fen = parse_castling(fen, &castling_rights);
+    if (!fen)
+        return -1;
+    pos->castling_rights = (uint8_t)castling_rights;
+    if (*fen++ != ' ')
+        return -1;
+
+    if (*fen == '-') {
+        ++fen;
+    } else {
+        if (fen[0] < 'a' || fen[0] > 'h')
+            return -1;
+        // the square a double pushed pawn skipped, seen from the side to move
+        int rank = us == WHITE ? 5 : 2;
+        if (fen[1] != '1' + rank)
+            return -1;
+        pos->en_passant = (uint8_t)make_square(fen[0] - 'a', rank);
+        fen += 2;
+    }
+
+    // optional half and full move counters
+    if (*fen == ' ') {
+        ++fen;
+        int halfmove = parse_number(&fen, 255);
+        if (halfmove < 0 || *fen++ != ' ')
+            return -1;
+        int fullmove = parse_number(&fen, 65535);
+        if (fullmove < 1)
+            return -1;
+        pos->halfmove_clock = (uint8_t)halfmove;
+        pos->fullmove_number = (uint16_t)fullmove;
+    }
+    while (*fen == ' ' || *fen == '\n' || *fen == '\r')
+        ++fen;
+    if (*fen)
+        return -1;
+
+    if (!castling_consistent(castling_rights, pieces, colors))
+        return -1;
+
+    uint64_t occupied = colors[WHITE] | colors[BLACK];
+    if (pos->en_passant != NO_SQUARE) {
+        // The pushed pawn stands in front of the skipped square and both
+        // squares it passed are empty, checked on the bitboards.
+        int ep = pos->en_passant;
+        uint64_t passed = us == WHITE ? square_bb(ep) | square_bb(ep + 8) : square_bb(ep) | square_bb(ep - 8);
+        uint64_t pushed = us == WHITE ? square_bb(ep - 8) : square_bb(ep + 8);
+        if ((passed & occupied) || !(pushed & pieces[PAWN] & colors[them]))
+            return -1;
+
+        // like make-move, only keep the square when it can be captured so
+        // equal positions get equal keys
+        if (!(pawn_attacks[them][ep] & pieces[PAWN] & colors[us]))
+            pos->en_passant = NO_SQUARE;
+    }
+
+    // The side that just moved must not be in check: one attack test on its
+    // king square with the pieces of the side to move only. Sliders are
+    // tested by what stands between them and the king, the occupancy
+    // indexed attack tables would mostly miss the cache here.
+    int king = lsb(us == WHITE ? black_king : white_king);
+    uint64_t attackers = (pawn_attacks[them][king] & pieces[PAWN]) | (knight_attacks[king] & pieces[KNIGHT])
+                       | (king_attacks[king] & pieces[KING]);
+    if (attackers & colors[us])
+        return -1;
+    uint64_t sliders = ((bishop_attacks(king, 0) & (pieces[BISHOP] | pieces[QUEEN]))
+                        | (rook_attacks(king, 0) & (pieces[ROOK] | pieces[QUEEN])))
+                     & colors[us];
+    while (sliders) {
+        if (!(between_bb[king][pop_lsb(&sliders)] & occupied))
+            return -1;
+    }
+
+    uint64_t key = 0;
+    for (uint64_t bb = occupied; bb;) {
+        int square = pop_lsb(&bb);
+        key ^= zobrist_pieces[squares[square ^ 56]][square];
+    }
+    key ^= zobrist_castling[pos->castling_rights];
+    if (pos->en_passant != NO_SQUARE)
+        key ^= zobrist_en_passant[square_file(pos->en_passant)];
+    if (us == BLACK)
+        key ^= zobrist_side;
+    pos->key = key;
+
+    return 0;
+}
+
+static char *write_number(char *out, unsigned int value)
+{
+    char digits[5];
+    int count = 0;
+
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count)
+        *out++ = digits[--count];
+    return out;
+}
+
+int position_get_fen(const struct position *pos, char buffer[FEN_MAX_LENGTH])
+{
+    char *out = buffer;
+    uint64_t occupied = position_occupied(pos);
+
+    // walk the occupied squares of each rank instead of all 64 squares
+    for (int rank = 7; rank >= 0; --rank) {
+        uint64_t pieces = (occupied >> (rank * 8)) & 0xFF;
+        int file = 0;
+
+        while (pieces) {
+            int next = pop_lsb(&pieces);
+            if (next > file)
+                *out++ = (char)('0' + next - file);
+            *out++ = piece_chars[position_piece_at(pos, rank * 8 + next)];
+            file = next + 1;
+        }
+        if (file < 8)
+            *out++ = (char)('0' + 8 - file);
+        *out++ = rank ? '/' : ' ';
+    }
+
+    *out++ = pos->side_to_move == WHITE ? 'w' : 'b';
+    *out++ = ' ';
+
+    if (!pos->castling_rights)
+        *out++ = '-';
+    for (int i = 0; i < 4; ++i) {
+        if (pos->castling_rights & (1 << i))
+            *out++ = "KQkq"[i];
+    }
+    *out++ = ' ';
+
+    if (pos->en_passant == NO_SQUARE) {
+        *out++ = '-';
+    } else {
+        *out++ = (char)('a' + square_file(pos->en_passant));
+        *out++ = (char)('1' + square_rank(pos->en_passant));
+    }
+    *out++ = ' ';
+
+    out = write_number(out, pos->halfmove_clock);
+    *out++ = ' ';
+    out = write_number(out, pos->fullmove_number);
+    *out = '\0';
+
+    return (int)(out - buffer);
+}
@@ -0,0 +1,21 @@
+#ifndef FEN_H
+#define FEN_H
+
+#include "position.h"
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// longest FEN produced by position_get_fen, including the terminator
+#define FEN_MAX_LENGTH 96
+
+// Strict FEN reader. Returns -1 and leaves pos unspecified unless the
+// string is a complete, legal position: 8 ranks of 8 squares, one king
+// each, no pawns on the back ranks, castling rights matching the king and
+// rook squares, a plausible en-passant square and the side that just moved
+// not in check. The two move counters may be omitted together (EPD style).
+int position_set_fen(struct position *pos, const char *fen);
+
+// writes the FEN of pos to buffer and returns its length
+int position_get_fen(const struct position *pos, char buffer[FEN_MAX_LENGTH]);
+
+#endif
@@ -0,0 +1,89 @@
+#include "game.h"
+
+#include "fen.h"
+#include "movegen.h"
+
+static void update_result(struct game *game)
+{
+    struct move_list list;
+    generate_legal_moves(&game->pos, &list);
+
+    game->draw_reason = DRAW_NONE;
+    if (list.count == 0) {
+        if (!position_checkers(&game->pos))
+            game->result = GAME_DRAW;
+        else
+            game->result = game->pos.side_to_move == WHITE ? GAME_BLACK_WINS : GAME_WHITE_WINS;
+        return;
+    }
+
+    game->draw_reason = position_draw_state(&game->pos, &game->history, 2);
+    game->result = game->draw_reason != DRAW_NONE ? GAME_DRAW : GAME_ONGOING;
+}
+
+int game_init(struct game *game, const char *fen)
+{
+    if (position_set_fen(&game->pos, fen) != 0)
+        return -1;
+
+    game->stack.count = 0;
+    key_history_clear(&game->history);
+    attack_map_init(&game->attacks, &game->pos);
+    update_result(game);
+    return 0;
+}
+
+int game_play(struct game *game, move m)
+{
+    if (game->result != GAME_ONGOING || !move_is_legal(&game->pos, m))
+        return -1;
+    if (game->stack.count == UNDO_STACK_SIZE)
+        return -1;
+
+    game->moves[game->stack.count] = m;
+    key_history_push(&game->history, game->pos.key);
+    position_make_move(&game->pos, &game->stack, m);
+    attack_map_update(&game->attacks, &game->pos, m);
+    update_result(game);
+    return 0;
+}
+
+int game_undo(struct game *game)
+{
+    if (game->stack.count == 0)
+        return -1;
+
+    move m = game->moves[game->stack.count - 1];
+    position_unmake_move(&game->pos, &game->stack, m);
+    attack_map_update(&game->attacks, &game->pos, m);
+    key_history_pop(&game->history);
+    update_result(game);
+    return 0;
+}
+
+move game_find_move(const struct game *game, int from, int to, int promotion)
+{
+    struct move_list list;
+    generate_legal_moves(&game->pos, &list);
+
+    for (int i = 0; i < list.count; ++i) {
+        move m = list.moves[i];
+        if (move_from(m) != from || move_to(m) != to)
+            continue;
+        if (move_flag(m) == MOVE_PROMOTION && move_promotion(m) != promotion)
+            continue;
+        return m;
+    }
+
+    return MOVE_NONE;
+}
+
+const char *game_result_name(const struct game *game)
+{
+    switch (game->result) {
+    case GAME_WHITE_WINS: return "1-0";
+    case GAME_BLACK_WINS: return "0-1";
+    case GAME_DRAW:       return "1/2-1/2";
+    default:              return "*";
+    }
+}
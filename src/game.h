@@ -0,0 +1,44 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "attack_map.h"
+#include "draw.h"
+#include "move.h"
+#include "position.h"
+
+enum game_result {
+    GAME_ONGOING,
+    GAME_WHITE_WINS,
+    GAME_BLACK_WINS,
+    GAME_DRAW
+};
+
+// A game from a start position: the current position, what is needed to
+// take moves back and the key history the draw rules and the engine use.
+struct game {
+    struct position pos;
+    struct undo_stack stack;
+    struct key_history history;
+    struct attack_map attacks;    // of pos, for showing checks and threats
+    move moves[UNDO_STACK_SIZE];  // moves played, stack.count of them
+    enum game_result result;
+    enum draw_reason draw_reason;
+};
+
+// returns -1 for an invalid FEN
+int game_init(struct game *game, const char *fen);
+
+// Plays m if the game is still going and m is legal, then decides whether
+// the game ended by mate, stalemate or a draw rule. Returns -1 otherwise.
+int game_play(struct game *game, move m);
+
+// takes back the last move, returns -1 if there is none
+int game_undo(struct game *game);
+
+// the legal move from the from square to the to square, promotions become
+// promotion, MOVE_NONE if there is no such move
+move game_find_move(const struct game *game, int from, int to, int promotion);
+
+const char *game_result_name(const struct game *game);
+
+#endif
@@ -0,0 +1,8 @@
+#include "history.h"
+
+#include <string.h>
+
+void history_clear(struct move_history *history)
+{
+    memset(history, 0, sizeof(*history));
+}
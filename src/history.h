@@ -0,0 +1,48 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "move.h"
+#include "position.h"
+
+// Every history score stays within [-HISTORY_MAX, HISTORY_MAX], which the
+// gravity update guarantees for bonuses up to HISTORY_MAX.
+#define HISTORY_MAX 16384
+
+// how many earlier plies the continuation history looks back
+#define CONTINUATION_PLIES 2
+
+// scores of a quiet move by the piece it moves and its destination
+typedef int16_t piece_to_history[PIECE_COUNT][64];
+
+// Quiet move statistics of one search thread. Butterfly history scores a
+// move by side, from and to square; the countermove table remembers the
+// move that refuted a piece arriving on a square; continuation history
+// scores a move by the move played one or two plies earlier. The
+// continuation tables are 2 MB, everything else fits in 18 KB.
+struct move_history {
+    int16_t butterfly[2][64][64];
+    move countermoves[PIECE_COUNT][64];
+    piece_to_history continuation[PIECE_COUNT][64];
+};
+
+void history_clear(struct move_history *history);
+
+// Bonus for a move that caused a cutoff at depth, the other quiet moves
+// searched before it get the same amount as a malus.
+static inline int history_bonus(int depth)
+{
+    int bonus = 32 * depth * depth;
+    return bonus < 2048 ? bonus : 2048;
+}
+
+// Gravity: the closer an entry is to the bound, the less it moves towards
+// it, so old results fade instead of saturating.
+static inline void history_update(int16_t *entry, int bonus)
+{
+    *entry += (int16_t)(bonus - *entry * abs(bonus) / HISTORY_MAX);
+}
+
+#endif
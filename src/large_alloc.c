@@ -0,0 +1,135 @@
+#include "large_alloc.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+// older headers only define the shift for the huge page size flags
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+#define SIZE_2MB ((size_t)2 << 20)
+#define SIZE_1GB ((size_t)1 << 30)
+
+static size_t round_up(size_t size, size_t unit)
+{
+    return (size + unit - 1) / unit * unit;
+}
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+static void *map_huge(size_t size, int size_flag)
+{
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag, -1, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+#endif
+
+// transparent huge pages are only used for 2 MB aligned ranges, so map a
+// little more and trim both ends
+static void *map_aligned(size_t size)
+{
+    size_t padded = size + SIZE_2MB;
+    char *memory = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return NULL;
+
+    char *aligned = (char *)round_up((uintptr_t)memory, SIZE_2MB);
+    if (aligned > memory)
+        munmap(memory, (size_t)(aligned - memory));
+    size_t tail = (size_t)(memory + padded - (aligned + size));
+    if (tail)
+        munmap(aligned + size, tail);
+
+    return aligned;
+}
+
+int large_alloc(struct large_alloc *alloc, size_t size)
+{
+    alloc->memory = NULL;
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_1GB)
+    if (size >= SIZE_1GB) {
+        alloc->size = round_up(size, SIZE_1GB);
+        alloc->memory = map_huge(alloc->size, MAP_HUGE_1GB);
+        alloc->pages = PAGES_HUGE_1GB;
+    }
+#endif
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+    if (!alloc->memory && size >= SIZE_2MB) {
+        alloc->size = round_up(size, SIZE_2MB);
+        alloc->memory = map_huge(alloc->size, MAP_HUGE_2MB);
+        alloc->pages = PAGES_HUGE_2MB;
+    }
+#endif
+
+    if (!alloc->memory) {
+        alloc->size = round_up(size, SIZE_2MB);
+        alloc->memory = map_aligned(alloc->size);
+        alloc->pages = PAGES_NORMAL;
+#ifdef MADV_HUGEPAGE
+        if (alloc->memory && madvise(alloc->memory, alloc->size, MADV_HUGEPAGE) == 0)
+            alloc->pages = PAGES_TRANSPARENT;
+#endif
+    }
+
+    if (!alloc->memory) {
+        alloc->size = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+void large_free(struct large_alloc *alloc)
+{
+    if (alloc->memory)
+        munmap(alloc->memory, alloc->size);
+    alloc->memory = NULL;
+    alloc->size = 0;
+}
+
+size_t large_alloc_huge_bytes(const struct large_alloc *alloc)
+{
+    if (alloc->pages == PAGES_HUGE_2MB || alloc->pages == PAGES_HUGE_1GB)
+        return alloc->size;
+
+    // the kernel reports the transparent huge pages of each mapping in smaps
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    if (!smaps)
+        return 0;
+
+    uintptr_t begin = (uintptr_t)alloc->memory;
+    uintptr_t end = begin + alloc->size;
+    size_t bytes = 0;
+    int inside = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), smaps)) {
+        unsigned long start, stop;
+        size_t kb;
+        if (sscanf(line, "%lx-%lx ", &start, &stop) == 2)
+            inside = start < end && stop > begin;
+        else if (inside && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+            bytes += kb * 1024;
+    }
+
+    fclose(smaps);
+    return bytes;
+}
+
+const char *page_kind_name(enum page_kind pages)
+{
+    switch (pages) {
+    case PAGES_TRANSPARENT: return "transparent huge pages";
+    case PAGES_HUGE_2MB:    return "2 MB huge pages";
+    case PAGES_HUGE_1GB:    return "1 GB huge pages";
+    default:                return "normal pages";
+    }
+}
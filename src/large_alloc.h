@@ -0,0 +1,31 @@
+#ifndef LARGE_ALLOC_H
+#define LARGE_ALLOC_H
+
+#include <stddef.h>
+
+enum page_kind {
+    PAGES_NORMAL,
+    PAGES_TRANSPARENT,  // normal mapping with transparent huge pages requested
+    PAGES_HUGE_2MB,
+    PAGES_HUGE_1GB
+};
+
+struct large_alloc {
+    void *memory;
+    size_t size;  // bytes mapped, at least the requested size
+    enum page_kind pages;
+};
+
+// Maps zeroed memory for large tables, trying explicit 1 GB and 2 MB huge
+// pages first, then a 2 MB aligned mapping with transparent huge pages
+// requested, then plain pages. Returns -1 if nothing could be mapped.
+int large_alloc(struct large_alloc *alloc, size_t size);
+void large_free(struct large_alloc *alloc);
+
+// Bytes of the mapping actually backed by transparent huge pages, only
+// meaningful once the memory has been touched. 0 where this can't be read.
+size_t large_alloc_huge_bytes(const struct large_alloc *alloc);
+
+const char *page_kind_name(enum page_kind pages);
+
+#endif
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include <GL/glew.h>
@@ -7,6 +8,7 @@
 
 #include <cglm/vec2.h>
 #include <cglm/vec3.h>
+#include <cglm/vec4.h>
 #include <cglm/affine.h>
 #include <cglm/mat4.h>
 #include <cglm/cam.h>
@@ -15,10 +17,22 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "attacks.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "fen.h"
+#include "game.h"
+#include "memory_report.h"
+#include "movegen.h"
+#include "numa_nodes.h"
+#include "position.h"
+
 void glfw_error_callback(int code, const char *description);
 void glfw_window_resize_callback(GLFWwindow *window, int width, int height);
 void glfw_framebuffer_callback(GLFWwindow *window, int width, int height);
 void glfw_mouse_position_callback(GLFWwindow *window, double xpos, double ypos);
+void glfw_mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+void glfw_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 
 struct vertex {
     vec3 position;
@@ -30,11 +44,133 @@ int window_height = 720;
 
 vec2 mouse_position;
 
+// game state shared with the input callbacks
+struct game game;
+struct engine engine;
+struct search_limits engine_limits;
+int engine_color = BLACK;       // -1 when both sides are played by hand
+unsigned engine_search_id;      // 0 while the engine isn't thinking
+int selected_square = NO_SQUARE;
+move last_move = MOVE_NONE;
+
+// pondering: the engine searches the reply it expects while the human thinks
+int ponder_enabled = 1;
+unsigned ponder_search_id;      // 0 while not pondering
+move ponder_move;
+int ponder_searches;
+int ponder_hits;
+double ponder_seconds_gained;
+
 void set_shader_mat4(unsigned int shader, const char *name, mat4 value)
 {
     glUniformMatrix4fv(glGetUniformLocation(shader, name), 1, GL_FALSE, &value[0][0]);
 }
 
+void set_shader_vec4(unsigned int shader, const char *name, vec4 value)
+{
+    glUniform4fv(glGetUniformLocation(shader, name), 1, value);
+}
+
+void play_move(move m)
+{
+    char uci[6];
+    move_to_uci(m, uci);
+    if (game_play(&game, m) != 0)
+        return;
+
+    printf("%s %s\n", game.pos.side_to_move == WHITE ? "black" : "white", uci);
+    last_move = m;
+    selected_square = NO_SQUARE;
+
+    if (game.result != GAME_ONGOING) {
+        printf("game over: %s%s%s\n", game_result_name(&game), game.draw_reason != DRAW_NONE ? ", " : "",
+               game.draw_reason != DRAW_NONE ? draw_reason_name(game.draw_reason) : "");
+        if (ponder_searches > 0) {
+            printf("pondering: %d of %d predictions hit, %.1f s of extra thinking time\n", ponder_hits,
+                   ponder_searches, ponder_seconds_gained);
+        }
+    }
+}
+
+// after the engine moved, search the position after the reply it expects
+void start_ponder(move expected)
+{
+    if (!ponder_enabled || game.result != GAME_ONGOING || !move_is_legal(&game.pos, expected))
+        return;
+
+    struct position pos;
+    struct key_history history = game.history;
+    key_history_push(&history, game.pos.key);
+    position_copy_make(&game.pos, &pos, expected);
+
+    struct search_limits limits = engine_limits;
+    limits.ponder = 1;
+    ponder_search_id = engine_go(&engine, &pos, &history, &limits);
+    if (ponder_search_id != 0) {
+        ponder_move = expected;
+        ponder_searches++;
+    }
+}
+
+// after the human moved: a ponder hit keeps the search going as the real
+// one, a miss throws it away
+void resolve_ponder(move played)
+{
+    if (ponder_search_id == 0)
+        return;
+
+    if (played == ponder_move) {
+        engine_ponderhit(&engine, ponder_search_id);
+        engine_search_id = ponder_search_id;
+        ponder_hits++;
+    } else {
+        engine_stop(&engine);
+    }
+    ponder_search_id = 0;
+}
+
+// "white", "black" or anything else for no side
+int parse_side(const char *side)
+{
+    if (strcmp(side, "white") == 0)
+        return WHITE;
+    if (strcmp(side, "black") == 0)
+        return BLACK;
+    return -1;
+}
+
+// starts a search whenever it is the engine's turn and none is running
+void update_engine(void)
+{
+    if (engine_search_id == 0 && game.result == GAME_ONGOING && game.pos.side_to_move == engine_color)
+        engine_search_id = engine_go(&engine, &game.pos, &game.history, &engine_limits);
+}
+
+// drains the engine events without waiting, called once per frame
+void poll_engine(void)
+{
+    struct engine_event event;
+    while (engine_poll(&engine, &event)) {
+        if (event.id == ponder_search_id && event.type == ENGINE_INFO) {
+            printf("ponder ");
+            search_print_report(stdout, &event.report);
+        }
+        if (event.id != engine_search_id)
+            continue;
+
+        if (event.type == ENGINE_INFO) {
+            search_print_report(stdout, &event.report);
+        } else {
+            engine_search_id = 0;
+            ponder_seconds_gained += event.result.ponder_seconds;
+            if (event.result.best_move != MOVE_NONE) {
+                play_move(event.result.best_move);
+                start_ponder(event.result.ponder_move);
+            }
+        }
+    }
+}
+
 
 unsigned int load_texture(const char *path)
 {
@@ -56,15 +192,25 @@ unsigned int load_texture(const char *path)
         printf("Failed to load texture: %s\n", path);
         return -1;
     }
+    memory_track(MEMORY_IMAGE, id, path, (size_t)width * height * nr_channels);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
+    // GL_RGBA is stored as 4 bytes per texel
+    memory_track(MEMORY_TEXTURE, id, path, memory_texture_size(width, height, 4, 1));
 
     stbi_image_free(data);
+    memory_release(MEMORY_IMAGE, id);
 
     return id;
 }
 
+void delete_texture(unsigned int id)
+{
+    memory_release(MEMORY_TEXTURE, id);
+    glDeleteTextures(1, &id);
+}
+
 
 void render_texture(unsigned int id, unsigned int shader, mat4 view_projection, mat4 model)
 {
@@ -79,8 +225,43 @@ void render_texture(unsigned int id, unsigned int shader, mat4 view_projection,
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
+    int print_memory_report = 0;
+    const char *fen = START_FEN;
+    int threads = 1;
+    size_t hash_mb = 64;
+    engine_limits.move_time_ms = 3000;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--mem-report") == 0)
+            print_memory_report = 1;
+        else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc)
+            fen = argv[++i];
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+            engine_color = parse_side(argv[++i]);
+        else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc)
+            engine_limits.move_time_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc)
+            hash_mb = (size_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--numa-interleave") == 0)
+            node_select_interleave(1);
+        else if (strcmp(argv[i], "--no-ponder") == 0)
+            ponder_enabled = 0;
+    }
+
+    attacks_init();
+
+    if (game_init(&game, fen) != 0) {
+        printf("Error: invalid FEN - %s\n", fen);
+        return -1;
+    }
+
+    if (engine_start(&engine, hash_mb, threads) != 0)
+        return -1;
+    tt_print_memory(stdout, &engine.search.tt);
+
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit()) {
         printf("Error: failed to initialize GLFW\n");
@@ -109,7 +290,11 @@ int main(void)
     glfwSetWindowSizeCallback(window, glfw_window_resize_callback);
     glfwSetFramebufferSizeCallback(window, glfw_framebuffer_callback);
     glfwSetCursorPosCallback(window, glfw_mouse_position_callback);
+    glfwSetMouseButtonCallback(window, glfw_mouse_button_callback);
+    glfwSetKeyCallback(window, glfw_key_callback);
     glfwSetWindowAspectRatio(window, 1, 1);
+    // render at the display refresh rate, the engine thinks on its own thread
+    glfwSwapInterval(1);
 
     glewExperimental = 1;
     if (glewInit() != GLEW_OK) {
@@ -143,9 +328,11 @@ int main(void)
     glBindVertexArray(quad_vao);
     glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+    memory_track(MEMORY_BUFFER, quad_vbo, "quad_vbo", sizeof(vertices));
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    memory_track(MEMORY_BUFFER, quad_ebo, "quad_ebo", sizeof(indices));
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(struct vertex), (void*)0);
@@ -173,9 +360,11 @@ int main(void)
             "out vec4 color;\n"
             "in vec2 texture_coords;\n"
             "uniform sampler2D texture1;\n"
+            "uniform vec4 tint;\n"
             "void main()\n"
             "{\n"
             "    color = texture(texture1, texture_coords);\n"
+            "    color.rgb = mix(color.rgb, tint.rgb, tint.a);\n"
             "}\n";
 
     int shader_success;
@@ -264,46 +453,44 @@ int main(void)
     }
 
 
-    // set chess pieces starting position
-    unsigned int piece_positions[tile_count][tile_count];
-    memset(piece_positions, -1, sizeof(piece_positions));
-    piece_positions[0][0] = white_rook_texture;
-    piece_positions[1][0] = white_knight_texture;
-    piece_positions[2][0] = white_bishop_texture;
-    piece_positions[3][0] = white_queen_texture;
-    piece_positions[4][0] = white_king_texture;
-    piece_positions[5][0] = white_bishop_texture;
-    piece_positions[6][0] = white_knight_texture;
-    piece_positions[7][0] = white_rook_texture;
-    piece_positions[0][1] = white_pawn_texture;
-    piece_positions[1][1] = white_pawn_texture;
-    piece_positions[2][1] = white_pawn_texture;
-    piece_positions[3][1] = white_pawn_texture;
-    piece_positions[4][1] = white_pawn_texture;
-    piece_positions[5][1] = white_pawn_texture;
-    piece_positions[6][1] = white_pawn_texture;
-    piece_positions[7][1] = white_pawn_texture;
-
-
-    piece_positions[0][7] = black_rook_texture;
-    piece_positions[1][7] = black_knight_texture;
-    piece_positions[2][7] = black_bishop_texture;
-    piece_positions[3][7] = black_queen_texture;
-    piece_positions[4][7] = black_king_texture;
-    piece_positions[5][7] = black_bishop_texture;
-    piece_positions[6][7] = black_knight_texture;
-    piece_positions[7][7] = black_rook_texture;
-    piece_positions[0][6] = black_pawn_texture;
-    piece_positions[1][6] = black_pawn_texture;
-    piece_positions[2][6] = black_pawn_texture;
-    piece_positions[3][6] = black_pawn_texture;
-    piece_positions[4][6] = black_pawn_texture;
-    piece_positions[5][6] = black_pawn_texture;
-    piece_positions[6][6] = black_pawn_texture;
-    piece_positions[7][6] = black_pawn_texture;
+    // renderer lookup from position pieces to their textures
+    unsigned int piece_textures[PIECE_COUNT];
+    memset(piece_textures, -1, sizeof(piece_textures));
+    piece_textures[WHITE_PAWN]   = white_pawn_texture;
+    piece_textures[WHITE_KNIGHT] = white_knight_texture;
+    piece_textures[WHITE_BISHOP] = white_bishop_texture;
+    piece_textures[WHITE_ROOK]   = white_rook_texture;
+    piece_textures[WHITE_QUEEN]  = white_queen_texture;
+    piece_textures[WHITE_KING]   = white_king_texture;
+    piece_textures[BLACK_PAWN]   = black_pawn_texture;
+    piece_textures[BLACK_KNIGHT] = black_knight_texture;
+    piece_textures[BLACK_BISHOP] = black_bishop_texture;
+    piece_textures[BLACK_ROOK]   = black_rook_texture;
+    piece_textures[BLACK_QUEEN]  = black_queen_texture;
+    piece_textures[BLACK_KING]   = black_king_texture;
+
+    if (print_memory_report)
+        memory_print_report(stdout);
+
+    update_engine();
 
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window)) {
+        poll_engine();
+        update_engine();
+
+        // squares to highlight: the selected piece, where it can go and the last move
+        uint64_t targets = selected_square != NO_SQUARE ? legal_targets(&game.pos, selected_square) : 0;
+        uint64_t last_move_squares = last_move != MOVE_NONE
+            ? square_bb(move_from(last_move)) | square_bb(move_to(last_move)) : 0;
+
+        // from the game's attack map: a king in check and the pieces of the
+        // side to move that the opponent attacks and nothing defends
+        int us = game.pos.side_to_move;
+        uint64_t king = position_pieces(&game.pos, us, KING);
+        uint64_t checked_king = king & game.attacks.by_color[us ^ 1];
+        uint64_t threatened = game.pos.colors[us] & ~king & game.attacks.by_color[us ^ 1] & ~game.attacks.by_color[us];
+
         /* Render here */
         glClear(GL_COLOR_BUFFER_BIT);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -335,10 +522,25 @@ int main(void)
                 }
 
 
+                int square = make_square(x, y);
+                vec4 tint = { 0.0f, 0.0f, 0.0f, 0.0f };
+                if (square == selected_square)
+                    glm_vec4_copy((vec4){ 1.0f, 0.9f, 0.2f, 0.5f }, tint);
+                else if (targets & square_bb(square))
+                    glm_vec4_copy((vec4){ 0.2f, 0.8f, 0.2f, 0.4f }, tint);
+                else if (checked_king & square_bb(square))
+                    glm_vec4_copy((vec4){ 1.0f, 0.1f, 0.1f, 0.5f }, tint);
+                else if (threatened & square_bb(square))
+                    glm_vec4_copy((vec4){ 1.0f, 0.5f, 0.1f, 0.4f }, tint);
+                else if (last_move_squares & square_bb(square))
+                    glm_vec4_copy((vec4){ 0.3f, 0.5f, 1.0f, 0.3f }, tint);
+
                 set_shader_mat4(shader, "view_projection", view_projection_matrix);
                 set_shader_mat4(shader, "model", transform);
+                set_shader_vec4(shader, "tint", tint);
 
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                set_shader_vec4(shader, "tint", (vec4){ 0.0f, 0.0f, 0.0f, 0.0f });
 
 
                 // cursor ray casting
@@ -350,9 +552,10 @@ int main(void)
 
 
                 // render chess pieces
-                if (piece_positions[x][y] != -1) {
+                int piece = position_piece_at(&game.pos, square);
+                if (piece != NO_PIECE) {
                     glm_scale_uni(transform, 0.8f);
-                    render_texture(piece_positions[x][y], shader, view_projection_matrix, transform);
+                    render_texture(piece_textures[piece], shader, view_projection_matrix, transform);
                 }
 
 
@@ -369,33 +572,36 @@ int main(void)
 
 
 
-    glDeleteTextures(1, &black_pawn_texture);
-    glDeleteTextures(1, &black_rook_texture);
-    glDeleteTextures(1, &black_knight_texture);
-    glDeleteTextures(1, &black_bishop_texture);
-    glDeleteTextures(1, &black_queen_texture);
-    glDeleteTextures(1, &black_king_texture);
+    delete_texture(black_pawn_texture);
+    delete_texture(black_rook_texture);
+    delete_texture(black_knight_texture);
+    delete_texture(black_bishop_texture);
+    delete_texture(black_queen_texture);
+    delete_texture(black_king_texture);
 
-    glDeleteTextures(1, &white_pawn_texture);
-    glDeleteTextures(1, &white_rook_texture);
-    glDeleteTextures(1, &white_knight_texture);
-    glDeleteTextures(1, &white_bishop_texture);
-    glDeleteTextures(1, &white_queen_texture);
-    glDeleteTextures(1, &white_king_texture);
+    delete_texture(white_pawn_texture);
+    delete_texture(white_rook_texture);
+    delete_texture(white_knight_texture);
+    delete_texture(white_bishop_texture);
+    delete_texture(white_queen_texture);
+    delete_texture(white_king_texture);
 
-    glDeleteTextures(1, &black_tile_texture);
-    glDeleteTextures(1, &white_tile_texture);
+    delete_texture(black_tile_texture);
+    delete_texture(white_tile_texture);
 
 
 
     glDeleteShader(shader);
 
 
+    memory_release(MEMORY_BUFFER, quad_ebo);
+    memory_release(MEMORY_BUFFER, quad_vbo);
     glDeleteBuffers(1, &quad_ebo);
     glDeleteBuffers(1, &quad_vbo);
     glDeleteVertexArrays(1, &quad_vao);
 
     glfwTerminate();
+    engine_quit(&engine);
 
     return 0;
 }
@@ -420,3 +626,37 @@ void glfw_mouse_position_callback(GLFWwindow *window, double xpos, double ypos)
 {
     glm_vec2((vec2){ (float)xpos, (float)ypos }, mouse_position);
 }
+
+void glfw_mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+        return;
+    if (game.result != GAME_ONGOING || game.pos.side_to_move == engine_color)
+        return;
+
+    // the board fills the window, rank 8 at the top
+    int file = (int)(mouse_position[0] / (float)window_width * 8.0f);
+    int rank = 7 - (int)(mouse_position[1] / (float)window_height * 8.0f);
+    if (file < 0 || file > 7 || rank < 0 || rank > 7)
+        return;
+    int square = make_square(file, rank);
+
+    // a second click on a highlighted square plays the move, promoting to a queen
+    if (selected_square != NO_SQUARE) {
+        move m = game_find_move(&game, selected_square, square, QUEEN);
+        if (m != MOVE_NONE) {
+            play_move(m);
+            resolve_ponder(m);
+            return;
+        }
+    }
+
+    selected_square = legal_targets(&game.pos, square) ? square : NO_SQUARE;
+}
+
+void glfw_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    // debug: dump memory usage
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        memory_print_report(stdout);
+}
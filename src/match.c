@@ -0,0 +1,499 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "attacks.h"
+#include "fen.h"
+#include "game.h"
+#include "movegen.h"
+#include "search.h"
+
+// Self-play match between two configurations of the engine, "test" and
+// "base", which differ in their search options. Every opening is played
+// twice with colors swapped, games run concurrently one per worker and the
+// match stops once the sequential probability ratio test decides.
+
+// games still going after this many plies are drawn
+#define MAX_GAME_PLIES 400
+
+// Built-in openings as UCI moves from the start position, a few plies into
+// well-known and roughly balanced lines.
+static const char *const builtin_openings[] = {
+    "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6",
+    "e2e4 e7e5 g1f3 b8c6 f1c4 f8c5",
+    "e2e4 e7e5 g1f3 b8c6 d2d4 e5d4",
+    "e2e4 e7e5 g1f3 g8f6 f3e5 d7d6",
+    "e2e4 e7e5 b1c3 g8f6 f2f4 d7d5",
+    "e2e4 c7c5 g1f3 d7d6 d2d4 c5d4",
+    "e2e4 c7c5 g1f3 b8c6 d2d4 c5d4",
+    "e2e4 c7c5 g1f3 e7e6 d2d4 c5d4",
+    "e2e4 c7c5 b1c3 b8c6 g2g3 g7g6",
+    "e2e4 c7c5 c2c3 g8f6 e4e5 f6d5",
+    "e2e4 e7e6 d2d4 d7d5 b1c3 g8f6",
+    "e2e4 e7e6 d2d4 d7d5 e4e5 c7c5",
+    "e2e4 c7c6 d2d4 d7d5 e4e5 c8f5",
+    "e2e4 c7c6 d2d4 d7d5 b1c3 d5e4",
+    "e2e4 d7d6 d2d4 g8f6 b1c3 g7g6",
+    "e2e4 g8f6 e4e5 f6d5 d2d4 d7d6",
+    "e2e4 d7d5 e4d5 d8d5 b1c3 d5a5",
+    "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6",
+    "d2d4 d7d5 c2c4 c7c6 g1f3 g8f6",
+    "d2d4 d7d5 c2c4 d5c4 g1f3 g8f6",
+    "d2d4 g8f6 c2c4 e7e6 b1c3 f8b4",
+    "d2d4 g8f6 c2c4 e7e6 g1f3 b7b6",
+    "d2d4 g8f6 c2c4 g7g6 b1c3 f8g7",
+    "d2d4 g8f6 c2c4 g7g6 b1c3 d7d5",
+    "d2d4 g8f6 c2c4 c7c5 d4d5 e7e6",
+    "d2d4 f7f5 g2g3 g8f6 f1g2 g7g6",
+    "d2d4 d7d5 g1f3 g8f6 c1f4 e7e6",
+    "c2c4 e7e5 b1c3 g8f6 g1f3 b8c6",
+    "c2c4 c7c5 g1f3 g8f6 b1c3 b8c6",
+    "c2c4 g8f6 b1c3 e7e6 e2e4 d7d5",
+    "g1f3 d7d5 g2g3 g8f6 f1g2 c7c6",
+    "g1f3 g8f6 c2c4 b7b6 g2g3 c8b7",
+};
+
+#define BUILTIN_OPENING_COUNT (sizeof(builtin_openings) / sizeof(builtin_openings[0]))
+
+// search options a configuration can switch off by name
+static const struct {
+    const char *name;
+    size_t offset;
+} option_names[] = {
+    { "killers", offsetof(struct search_options, killers) },
+    { "history", offsetof(struct search_options, history) },
+    { "countermoves", offsetof(struct search_options, countermoves) },
+    { "continuation_history", offsetof(struct search_options, continuation_history) },
+    { "null_move", offsetof(struct search_options, null_move) },
+    { "late_move_reductions", offsetof(struct search_options, late_move_reductions) },
+    { "reverse_futility", offsetof(struct search_options, reverse_futility) },
+    { "futility", offsetof(struct search_options, futility) },
+    { "singular_extensions", offsetof(struct search_options, singular_extensions) },
+    { "attack_eval", offsetof(struct search_options, attack_eval) },
+};
+
+#define OPTION_NAME_COUNT (sizeof(option_names) / sizeof(option_names[0]))
+
+enum { TEST, BASE };
+
+struct match {
+    // settings, fixed once the workers start
+    char (*openings)[FEN_MAX_LENGTH];
+    int opening_count;
+    int max_games;
+    struct search_limits limits;
+    size_t hash_mb;
+    int disabled[2][OPTION_NAME_COUNT];
+    double elo0, elo1;
+    double lower_bound, upper_bound;
+
+    atomic_int next_game;
+    atomic_bool done;
+
+    // results from the test configuration's point of view
+    pthread_mutex_t lock;
+    int wins, losses, draws;
+    double start_time;
+};
+
+struct worker {
+    struct match *match;
+    pthread_t handle;
+    struct search engines[2];
+    int ready;
+};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double elo_to_score(double elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+static double score_to_elo(double score)
+{
+    if (score <= 0.0)
+        return -INFINITY;
+    if (score >= 1.0)
+        return INFINITY;
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+// Log-likelihood ratio of elo1 against elo0 for the trinomial results so
+// far, using the normal approximation of the generalized SPRT.
+static double sprt_llr(int wins, int losses, int draws, double elo0, double elo1)
+{
+    int games = wins + losses + draws;
+    if (games == 0)
+        return 0.0;
+
+    double score = (wins + 0.5 * draws) / games;
+    double variance = (wins * (1.0 - score) * (1.0 - score) + losses * score * score
+                       + draws * (0.5 - score) * (0.5 - score)) / games;
+    // all games with the same result tell nothing about the spread yet
+    if (variance <= 0.0)
+        return 0.0;
+    double s0 = elo_to_score(elo0);
+    double s1 = elo_to_score(elo1);
+    return games * (s1 - s0) * (2.0 * score - s0 - s1) / (2.0 * variance);
+}
+
+static void print_status(const struct match *match)
+{
+    int games = match->wins + match->losses + match->draws;
+    double score = (match->wins + 0.5 * match->draws) / games;
+    double variance = (match->wins * (1.0 - score) * (1.0 - score) + match->losses * score * score
+                       + match->draws * (0.5 - score) * (0.5 - score)) / games;
+    // 95% confidence interval of the mean score
+    double margin = 1.96 * sqrt(variance / games);
+    double llr = sprt_llr(match->wins, match->losses, match->draws, match->elo0, match->elo1);
+
+    // elo is infinite at a score of 0 or 1, the error bar as soon as the
+    // interval reaches either of them
+    char elo[64];
+    if (score - margin > 0.0 && score + margin < 1.0)
+        snprintf(elo, sizeof(elo), "%.1f +/- %.1f", score_to_elo(score),
+                 (score_to_elo(score + margin) - score_to_elo(score - margin)) / 2.0);
+    else if (score > 0.0 && score < 1.0)
+        snprintf(elo, sizeof(elo), "%.1f", score_to_elo(score));
+    else
+        snprintf(elo, sizeof(elo), "%s", score > 0.0 ? "+inf" : "-inf");
+
+    printf("games %5d: +%d -%d =%d  score %.1f%%  elo %s  llr %.2f [%.2f, %.2f]  %.1f games/s\n", games,
+           match->wins, match->losses, match->draws, 100.0 * score, elo, llr, match->lower_bound,
+           match->upper_bound, games / (now_seconds() - match->start_time));
+    fflush(stdout);
+}
+
+// Plays one game and returns the test configuration's score: 1, 0.5 or 0.
+static double play_game(struct worker *worker, const char *fen, int test_color)
+{
+    struct match *match = worker->match;
+    struct game game;
+    if (game_init(&game, fen) != 0)
+        return 0.5;
+
+    for (int i = 0; i < 2; ++i)
+        search_clear(&worker->engines[i]);
+
+    while (game.result == GAME_ONGOING && game.stack.count < MAX_GAME_PLIES) {
+        if (atomic_load_explicit(&match->done, memory_order_relaxed))
+            return -1.0;
+
+        struct search *engine = &worker->engines[game.pos.side_to_move == test_color ? TEST : BASE];
+        struct search_result result = search_run(engine, &game.pos, &game.history, &match->limits);
+        if (game_play(&game, result.best_move) != 0)
+            break;
+    }
+
+    if (game.result == GAME_WHITE_WINS)
+        return test_color == WHITE ? 1.0 : 0.0;
+    if (game.result == GAME_BLACK_WINS)
+        return test_color == BLACK ? 1.0 : 0.0;
+    return 0.5;
+}
+
+static void *worker_main(void *arg)
+{
+    struct worker *worker = arg;
+    struct match *match = worker->match;
+
+    while (!atomic_load(&match->done)) {
+        int index = atomic_fetch_add(&match->next_game, 1);
+        if (index >= match->max_games)
+            break;
+
+        // game pairs: both colors of each opening
+        const char *fen = match->openings[(index / 2) % match->opening_count];
+        int test_color = index % 2 == 0 ? WHITE : BLACK;
+        double score = play_game(worker, fen, test_color);
+        if (score < 0.0)
+            break;
+
+        pthread_mutex_lock(&match->lock);
+        if (score == 1.0)
+            match->wins++;
+        else if (score == 0.0)
+            match->losses++;
+        else
+            match->draws++;
+
+        int games = match->wins + match->losses + match->draws;
+        double llr = sprt_llr(match->wins, match->losses, match->draws, match->elo0, match->elo1);
+        int decided = llr <= match->lower_bound || llr >= match->upper_bound;
+        if (decided || games % 20 == 0 || games == match->max_games)
+            print_status(match);
+        if (decided && !atomic_exchange(&match->done, 1))
+            printf("SPRT: %s\n", llr >= match->upper_bound ? "H1 accepted, elo >= elo1" : "H0 accepted, elo <= elo0");
+        pthread_mutex_unlock(&match->lock);
+    }
+
+    return NULL;
+}
+
+// the start position after the UCI moves in line, -1 if one is illegal
+static int opening_from_moves(const char *line, char fen[FEN_MAX_LENGTH])
+{
+    struct game game;
+    game_init(&game, START_FEN);
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", line);
+    for (char *token = strtok(buffer, " "); token; token = strtok(NULL, " ")) {
+        struct move_list list;
+        generate_legal_moves(&game.pos, &list);
+
+        move found = MOVE_NONE;
+        for (int i = 0; i < list.count; ++i) {
+            char uci[6];
+            move_to_uci(list.moves[i], uci);
+            if (strcmp(uci, token) == 0)
+                found = list.moves[i];
+        }
+        if (found == MOVE_NONE || game_play(&game, found) != 0)
+            return -1;
+    }
+
+    position_get_fen(&game.pos, fen);
+    return 0;
+}
+
+// One FEN or EPD position per line, empty lines and # comments are skipped.
+static int load_openings(struct match *match, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("Error: can't open opening file %s\n", path);
+        return -1;
+    }
+
+    int capacity = 0;
+    char line[512];
+    for (int number = 1; fgets(line, sizeof(line), file); ++number) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+            continue;
+
+        struct position pos;
+        if (position_set_fen(&pos, line) != 0) {
+            printf("Error: invalid FEN in %s line %d - %s\n", path, number, line);
+            fclose(file);
+            return -1;
+        }
+
+        if (match->opening_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            char (*openings)[FEN_MAX_LENGTH] = realloc(match->openings, sizeof(*openings) * (size_t)capacity);
+            if (!openings) {
+                printf("Error: failed to allocate openings\n");
+                fclose(file);
+                return -1;
+            }
+            match->openings = openings;
+        }
+        position_get_fen(&pos, match->openings[match->opening_count++]);
+    }
+
+    fclose(file);
+    if (match->opening_count == 0) {
+        printf("Error: no positions in %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int load_builtin_openings(struct match *match)
+{
+    match->openings = malloc(sizeof(*match->openings) * BUILTIN_OPENING_COUNT);
+    if (!match->openings) {
+        printf("Error: failed to allocate openings\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < BUILTIN_OPENING_COUNT; ++i) {
+        if (opening_from_moves(builtin_openings[i], match->openings[i]) != 0) {
+            printf("Error: illegal built-in opening - %s\n", builtin_openings[i]);
+            return -1;
+        }
+    }
+    match->opening_count = (int)BUILTIN_OPENING_COUNT;
+    return 0;
+}
+
+static int disable_option(struct match *match, int engine, const char *name)
+{
+    for (size_t i = 0; i < OPTION_NAME_COUNT; ++i) {
+        if (strcmp(option_names[i].name, name) == 0) {
+            match->disabled[engine][i] = 1;
+            return 0;
+        }
+    }
+
+    printf("Error: unknown search option %s\n", name);
+    return -1;
+}
+
+static int worker_init(struct worker *worker, struct match *match)
+{
+    worker->match = match;
+    for (int i = 0; i < 2; ++i) {
+        if (search_init(&worker->engines[i], match->hash_mb, NULL, NULL) != 0) {
+            if (i == 1)
+                search_free(&worker->engines[0]);
+            return -1;
+        }
+        for (size_t j = 0; j < OPTION_NAME_COUNT; ++j) {
+            if (match->disabled[i][j])
+                *(int *)((char *)&worker->engines[i].options + option_names[j].offset) = 0;
+        }
+    }
+    worker->ready = 1;
+    return 0;
+}
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("  --games <n>         stop after n games (default: 20000)\n");
+    printf("  --concurrency <n>   games played at once (default: all cores)\n");
+    printf("  --nodes <n>         nodes per move (default: 20000)\n");
+    printf("  --movetime <ms>     time per move instead of a node limit\n");
+    printf("  --hash <mb>         transposition table per engine (default: 8)\n");
+    printf("  --openings <file>   FEN or EPD per line (default: built-in suite)\n");
+    printf("  --test-off <name>   switch a search option off in the test engine\n");
+    printf("  --base-off <name>   switch a search option off in the base engine\n");
+    printf("  --elo0 <elo>        SPRT null hypothesis (default: 0)\n");
+    printf("  --elo1 <elo>        SPRT alternative hypothesis (default: 5)\n");
+    printf("  --alpha <p>         SPRT false positive rate (default: 0.05)\n");
+    printf("  --beta <p>          SPRT false negative rate (default: 0.05)\n");
+    printf("search options:");
+    for (size_t i = 0; i < OPTION_NAME_COUNT; ++i)
+        printf(" %s", option_names[i].name);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    static struct match match;
+    match.max_games = 20000;
+    match.limits.nodes = 20000;
+    match.hash_mb = 8;
+    match.elo0 = 0.0;
+    match.elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+    const char *openings_path = NULL;
+    int concurrency = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            match.max_games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--concurrency") == 0 && i + 1 < argc) {
+            concurrency = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            match.limits.nodes = (uint64_t)atoll(argv[++i]);
+            match.limits.move_time_ms = 0;
+        } else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) {
+            match.limits.move_time_ms = atoi(argv[++i]);
+            match.limits.nodes = 0;
+        } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            match.hash_mb = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--openings") == 0 && i + 1 < argc) {
+            openings_path = argv[++i];
+        } else if (strcmp(argv[i], "--test-off") == 0 && i + 1 < argc) {
+            if (disable_option(&match, TEST, argv[++i]) != 0)
+                return -1;
+        } else if (strcmp(argv[i], "--base-off") == 0 && i + 1 < argc) {
+            if (disable_option(&match, BASE, argv[++i]) != 0)
+                return -1;
+        } else if (strcmp(argv[i], "--elo0") == 0 && i + 1 < argc) {
+            match.elo0 = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--elo1") == 0 && i + 1 < argc) {
+            match.elo1 = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+            alpha = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--beta") == 0 && i + 1 < argc) {
+            beta = atof(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (match.max_games < 1 || match.elo1 <= match.elo0 || alpha <= 0.0 || alpha >= 1.0 || beta <= 0.0
+        || beta >= 1.0) {
+        print_usage(argv[0]);
+        return -1;
+    }
+    if (concurrency < 1)
+        concurrency = 1;
+    match.lower_bound = log(beta / (1.0 - alpha));
+    match.upper_bound = log((1.0 - beta) / alpha);
+
+    attacks_init();
+
+    if (openings_path ? load_openings(&match, openings_path) != 0 : load_builtin_openings(&match) != 0)
+        return -1;
+
+    struct worker *workers = calloc((size_t)concurrency, sizeof(*workers));
+    if (!workers) {
+        printf("Error: failed to allocate %d workers\n", concurrency);
+        return -1;
+    }
+
+    pthread_mutex_init(&match.lock, NULL);
+    atomic_init(&match.next_game, 0);
+    atomic_init(&match.done, 0);
+
+    if (match.limits.nodes)
+        printf("%d games, %d openings, %d concurrent, %llu nodes per move\n", match.max_games,
+               match.opening_count, concurrency, (unsigned long long)match.limits.nodes);
+    else
+        printf("%d games, %d openings, %d concurrent, %d ms per move\n", match.max_games, match.opening_count,
+               concurrency, match.limits.move_time_ms);
+    printf("SPRT elo0 %.1f elo1 %.1f alpha %.3f beta %.3f\n", match.elo0, match.elo1, alpha, beta);
+
+    // the match goes on with fewer workers if some can't be started
+    match.start_time = now_seconds();
+    int started = 0;
+    for (; started < concurrency; ++started) {
+        if (worker_init(&workers[started], &match) != 0)
+            break;
+        // every table is allocated the same way
+        if (started == 0)
+            tt_print_memory(stdout, &workers[0].engines[TEST].tt);
+        if (pthread_create(&workers[started].handle, NULL, worker_main, &workers[started]) != 0)
+            break;
+    }
+    if (started == 0)
+        printf("Error: failed to start any worker\n");
+
+    for (int i = 0; i < started; ++i)
+        pthread_join(workers[i].handle, NULL);
+
+    if (match.wins + match.losses + match.draws > 0 && !atomic_load(&match.done))
+        printf("SPRT: inconclusive after %d games\n", match.wins + match.losses + match.draws);
+
+    for (int i = 0; i < concurrency; ++i) {
+        if (workers[i].ready) {
+            search_free(&workers[i].engines[TEST]);
+            search_free(&workers[i].engines[BASE]);
+        }
+    }
+    free(workers);
+    free(match.openings);
+    pthread_mutex_destroy(&match.lock);
+
+    return started > 0 ? 0 : -1;
+}
@@ -0,0 +1,100 @@
+#include "memory_report.h"
+
+#include <string.h>
+
+#define MAX_TRACKED_ALLOCATIONS 256
+
+struct memory_allocation {
+    enum memory_category category;
+    unsigned int id;
+    const char *label;
+    size_t bytes;
+};
+
+static struct memory_allocation allocations[MAX_TRACKED_ALLOCATIONS];
+static int allocation_count;
+
+static size_t current_bytes[MEMORY_CATEGORY_COUNT];
+static size_t peak_bytes[MEMORY_CATEGORY_COUNT];
+static size_t total_bytes;
+static size_t total_peak_bytes;
+
+static const char *category_names[MEMORY_CATEGORY_COUNT] = {
+    "textures",
+    "buffers",
+    "decoded images"
+};
+
+void memory_track(enum memory_category category, unsigned int id, const char *label, size_t bytes)
+{
+    if (allocation_count == MAX_TRACKED_ALLOCATIONS) {
+        printf("Warning: memory report is full, not tracking %s\n", label);
+        return;
+    }
+
+    allocations[allocation_count++] = (struct memory_allocation){ category, id, label, bytes };
+
+    current_bytes[category] += bytes;
+    if (current_bytes[category] > peak_bytes[category])
+        peak_bytes[category] = current_bytes[category];
+
+    total_bytes += bytes;
+    if (total_bytes > total_peak_bytes)
+        total_peak_bytes = total_bytes;
+}
+
+void memory_release(enum memory_category category, unsigned int id)
+{
+    for (int i = 0; i < allocation_count; ++i) {
+        if (allocations[i].category != category || allocations[i].id != id)
+            continue;
+
+        current_bytes[category] -= allocations[i].bytes;
+        total_bytes -= allocations[i].bytes;
+        allocations[i] = allocations[--allocation_count];
+        return;
+    }
+}
+
+size_t memory_texture_size(int width, int height, int bytes_per_pixel, int mipmapped)
+{
+    size_t total = 0;
+
+    // each mip level halves both dimensions (rounding down, minimum 1) until 1x1
+    for (;;) {
+        total += (size_t)width * (size_t)height * (size_t)bytes_per_pixel;
+        if (!mipmapped || (width == 1 && height == 1))
+            break;
+
+        width  = width  > 1 ? width  / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    return total;
+}
+
+size_t memory_current(enum memory_category category)
+{
+    return current_bytes[category];
+}
+
+size_t memory_peak(enum memory_category category)
+{
+    return peak_bytes[category];
+}
+
+void memory_print_report(FILE *stream)
+{
+    fprintf(stream, "Memory report\n");
+    for (int c = 0; c < MEMORY_CATEGORY_COUNT; ++c) {
+        fprintf(stream, "  %-16s %10.2f KiB (peak %10.2f KiB)\n", category_names[c],
+                current_bytes[c] / 1024.0, peak_bytes[c] / 1024.0);
+
+        for (int i = 0; i < allocation_count; ++i) {
+            if (allocations[i].category == (enum memory_category)c)
+                fprintf(stream, "    %10.2f KiB  %s\n", allocations[i].bytes / 1024.0, allocations[i].label);
+        }
+    }
+    fprintf(stream, "  %-16s %10.2f KiB (peak %10.2f KiB)\n", "total",
+            total_bytes / 1024.0, total_peak_bytes / 1024.0);
+}
@@ -0,0 +1,28 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Memory accounting for GPU resources and CPU-side decoded images. Every
+// allocation is recorded under its category and GL id so it can be
+// released again when the resource is deleted.
+enum memory_category {
+    MEMORY_TEXTURE,
+    MEMORY_BUFFER,
+    MEMORY_IMAGE,
+    MEMORY_CATEGORY_COUNT
+};
+
+void memory_track(enum memory_category category, unsigned int id, const char *label, size_t bytes);
+void memory_release(enum memory_category category, unsigned int id);
+
+// bytes of an uncompressed texture including its full mip chain (when mipmapped)
+size_t memory_texture_size(int width, int height, int bytes_per_pixel, int mipmapped);
+
+size_t memory_current(enum memory_category category);
+size_t memory_peak(enum memory_category category);
+
+void memory_print_report(FILE *stream);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <stdint.h>
+
+enum move_flag {
+    MOVE_NORMAL,
+    MOVE_PROMOTION,
+    MOVE_EN_PASSANT,
+    MOVE_CASTLING
+};
+
+// A move packed into 16 bits:
+//   bits  0-5   from square
+//   bits  6-11  to square
+//   bits 12-13  promotion piece type - KNIGHT (knight, bishop, rook, queen)
+//   bits 14-15  move_flag
+typedef uint16_t move;
+
+// a1a1 can never be played, so 0 doubles as "no move"
+#define MOVE_NONE ((move)0)
+
+// no legal chess position has more than 218 moves
+#define MAX_MOVES 256
+
+// fixed capacity so move lists live on the stack and are filled in place
+struct move_list {
+    int count;
+    move moves[MAX_MOVES];
+};
+
+static inline move encode_move(int from, int to, int flag, int promotion)
+{
+    // piece types are KNIGHT (1) to QUEEN (4) for promotions
+    return (move)(from | to << 6 | ((promotion - 1) & 3) << 12 | flag << 14);
+}
+
+static inline int move_from(move m)
+{
+    return m & 63;
+}
+
+static inline int move_to(move m)
+{
+    return (m >> 6) & 63;
+}
+
+static inline int move_flag(move m)
+{
+    return m >> 14;
+}
+
+// piece type promoted to, only meaningful for MOVE_PROMOTION
+static inline int move_promotion(move m)
+{
+    return ((m >> 12) & 3) + 1;
+}
+
+// long algebraic notation as used by UCI, e.g. e2e4 or e7e8q
+static inline void move_to_uci(move m, char buffer[6])
+{
+    buffer[0] = (char)('a' + (move_from(m) & 7));
+    buffer[1] = (char)('1' + (move_from(m) >> 3));
+    buffer[2] = (char)('a' + (move_to(m) & 7));
+    buffer[3] = (char)('1' + (move_to(m) >> 3));
+    buffer[4] = move_flag(m) == MOVE_PROMOTION ? " nbrq"[move_promotion(m)] : '\0';
+    buffer[5] = '\0';
+}
+
+#endif
@@ -0,0 +1,323 @@
+#include "movegen.h"
+
+#include "attacks.h"
+#include "bitboard.h"
+
+uint64_t attackers_to(const struct position *pos, int square, uint64_t occupied)
+{
+    return (pawn_attacks[BLACK][square] & position_pieces(pos, WHITE, PAWN))
+         | (pawn_attacks[WHITE][square] & position_pieces(pos, BLACK, PAWN))
+         | (knight_attacks[square] & pos->pieces[KNIGHT])
+         | (king_attacks[square] & pos->pieces[KING])
+         | (bishop_attacks(square, occupied) & (pos->pieces[BISHOP] | pos->pieces[QUEEN]))
+         | (rook_attacks(square, occupied) & (pos->pieces[ROOK] | pos->pieces[QUEEN]));
+}
+
+uint64_t position_checkers(const struct position *pos)
+{
+    int us = pos->side_to_move;
+    return attackers_to(pos, position_king_square(pos, us), position_occupied(pos)) & pos->colors[us ^ 1];
+}
+
+static inline move *add_moves(move *moves, int from, uint64_t targets)
+{
+    while (targets)
+        *moves++ = encode_move(from, pop_lsb(&targets), MOVE_NORMAL, 0);
+    return moves;
+}
+
+static inline move *add_promotions(move *moves, int from, int to)
+{
+    *moves++ = encode_move(from, to, MOVE_PROMOTION, QUEEN);
+    *moves++ = encode_move(from, to, MOVE_PROMOTION, ROOK);
+    *moves++ = encode_move(from, to, MOVE_PROMOTION, BISHOP);
+    *moves++ = encode_move(from, to, MOVE_PROMOTION, KNIGHT);
+    return moves;
+}
+
+// adds pawn moves for a set of destinations that share one origin offset
+static inline move *add_pawn_moves(move *moves, uint64_t targets, int offset, uint64_t promotion_rank)
+{
+    uint64_t promotions = targets & promotion_rank;
+    targets &= ~promotion_rank;
+
+    while (promotions) {
+        int to = pop_lsb(&promotions);
+        moves = add_promotions(moves, to - offset, to);
+    }
+    while (targets) {
+        int to = pop_lsb(&targets);
+        *moves++ = encode_move(to - offset, to, MOVE_NORMAL, 0);
+    }
+    return moves;
+}
+
+static inline uint64_t shift_forward(uint64_t bb, int color)
+{
+    return color == WHITE ? bb << 8 : bb >> 8;
+}
+
+// is square attacked by them once our king has been lifted off the board
+static inline int king_square_attacked(const struct position *pos, int square, int them, uint64_t occupied)
+{
+    return (attackers_to(pos, square, occupied) & pos->colors[them]) != 0;
+}
+
+static int en_passant_legal(const struct position *pos, int from, int to, int king_square)
+{
+    int us = pos->side_to_move;
+    int them = us ^ 1;
+    int captured = to + (us == WHITE ? -8 : 8);
+
+    // two pieces leave the capturing rank, so discovered attacks along it
+    // (and every other line) are checked on the resulting occupancy
+    uint64_t occupied = (position_occupied(pos) ^ square_bb(from) ^ square_bb(captured)) | square_bb(to);
+    uint64_t attackers = attackers_to(pos, king_square, occupied) & pos->colors[them] & ~square_bb(captured);
+
+    return attackers == 0;
+}
+
+static move *generate_pawn_moves(const struct position *pos, move *moves, int type,
+                                 uint64_t pawns, uint64_t check_mask, uint64_t pinned, int king_square)
+{
+    int us = pos->side_to_move;
+    int them = us ^ 1;
+    int up = us == WHITE ? 8 : -8;
+    uint64_t empty = ~position_occupied(pos);
+    uint64_t enemies = pos->colors[them];
+    uint64_t promotion_rank = us == WHITE ? RANK_8_BB : RANK_1_BB;
+    uint64_t double_push_rank = us == WHITE ? RANK_1_BB << 24 : RANK_1_BB << 32;
+
+    // unpinned pawns are generated set-wise
+    uint64_t free_pawns = pawns & ~pinned;
+    uint64_t single = shift_forward(free_pawns, us) & empty & check_mask;
+    uint64_t twice = shift_forward(shift_forward(free_pawns, us) & empty, us) & empty & double_push_rank & check_mask;
+    uint64_t west = (shift_forward(free_pawns & ~FILE_A_BB, us) >> 1) & enemies & check_mask;
+    uint64_t east = (shift_forward(free_pawns & ~FILE_H_BB, us) << 1) & enemies & check_mask;
+
+    // captures and all promotions are noisy, the remaining pushes quiet
+    if (type != GEN_QUIETS) {
+        moves = add_pawn_moves(moves, single & promotion_rank, up, promotion_rank);
+        moves = add_pawn_moves(moves, west, up - 1, promotion_rank);
+        moves = add_pawn_moves(moves, east, up + 1, promotion_rank);
+    }
+    if (type != GEN_NOISY) {
+        moves = add_pawn_moves(moves, single & ~promotion_rank, up, 0);
+        moves = add_pawn_moves(moves, twice, 2 * up, 0);
+    }
+
+    // pinned pawns may only move along the line through the king
+    uint64_t pinned_pawns = pawns & pinned;
+    uint64_t type_mask = type == GEN_NOISY ? enemies | promotion_rank : type == GEN_QUIETS ? ~enemies & ~promotion_rank : ~0ULL;
+    while (pinned_pawns) {
+        int from = pop_lsb(&pinned_pawns);
+        uint64_t push = shift_forward(square_bb(from), us) & empty;
+        uint64_t targets = push | (shift_forward(push, us) & empty & double_push_rank) | (pawn_attacks[us][from] & enemies);
+
+        targets &= check_mask & line_bb[king_square][from] & type_mask;
+        while (targets) {
+            int to = pop_lsb(&targets);
+            if (square_bb(to) & promotion_rank)
+                moves = add_promotions(moves, from, to);
+            else
+                *moves++ = encode_move(from, to, MOVE_NORMAL, 0);
+        }
+    }
+
+    if (pos->en_passant != NO_SQUARE && type != GEN_QUIETS) {
+        uint64_t capturers = pawn_attacks[them][pos->en_passant] & pawns;
+        while (capturers) {
+            int from = pop_lsb(&capturers);
+            if (en_passant_legal(pos, from, pos->en_passant, king_square))
+                *moves++ = encode_move(from, pos->en_passant, MOVE_EN_PASSANT, 0);
+        }
+    }
+
+    return moves;
+}
+
+static move *generate_castling(const struct position *pos, move *moves)
+{
+    int us = pos->side_to_move;
+    int them = us ^ 1;
+    uint64_t occupied = position_occupied(pos);
+    int king_side  = us == WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+    int queen_side = us == WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+    int base = us == WHITE ? A1 : A8;
+
+    if ((pos->castling_rights & king_side) && !(occupied & (square_bb(base + 5) | square_bb(base + 6)))
+        && !king_square_attacked(pos, base + 5, them, occupied)
+        && !king_square_attacked(pos, base + 6, them, occupied))
+        *moves++ = encode_move(base + 4, base + 6, MOVE_CASTLING, 0);
+
+    if ((pos->castling_rights & queen_side)
+        && !(occupied & (square_bb(base + 1) | square_bb(base + 2) | square_bb(base + 3)))
+        && !king_square_attacked(pos, base + 3, them, occupied)
+        && !king_square_attacked(pos, base + 2, them, occupied))
+        *moves++ = encode_move(base + 4, base + 2, MOVE_CASTLING, 0);
+
+    return moves;
+}
+
+// generates the legal moves of the given type for our pieces on from_mask
+static int generate(const struct position *pos, move *list, int type, uint64_t from_mask)
+{
+    move *moves = list;
+    int us = pos->side_to_move;
+    int them = us ^ 1;
+    uint64_t occupied = position_occupied(pos);
+    uint64_t own = pos->colors[us];
+    int king_square = position_king_square(pos, us);
+    uint64_t checkers = attackers_to(pos, king_square, occupied) & pos->colors[them];
+
+    uint64_t type_mask = type == GEN_NOISY ? pos->colors[them] : type == GEN_QUIETS ? ~occupied : ~own;
+
+    // king moves, tested with the king removed so it cannot hide behind itself
+    if (from_mask & square_bb(king_square)) {
+        uint64_t king_targets = king_attacks[king_square] & ~own & type_mask;
+        uint64_t occupied_without_king = occupied ^ square_bb(king_square);
+        while (king_targets) {
+            int to = pop_lsb(&king_targets);
+            if (!king_square_attacked(pos, to, them, occupied_without_king))
+                *moves++ = encode_move(king_square, to, MOVE_NORMAL, 0);
+        }
+    }
+
+    // in double check only the king can move
+    if (more_than_one(checkers))
+        return (int)(moves - list);
+
+    // destinations that resolve a single check: capture the checker or block
+    uint64_t check_mask = ~0ULL;
+    if (checkers) {
+        int checker = lsb(checkers);
+        check_mask = between_bb[king_square][checker] | checkers;
+    }
+
+    // an own piece is pinned when it is the only piece between our king and
+    // an enemy slider on the same line
+    uint64_t pinned = 0;
+    uint64_t snipers = (rook_attacks(king_square, pos->colors[them]) & (pos->pieces[ROOK] | pos->pieces[QUEEN]))
+                     | (bishop_attacks(king_square, pos->colors[them]) & (pos->pieces[BISHOP] | pos->pieces[QUEEN]));
+    snipers &= pos->colors[them];
+    while (snipers) {
+        uint64_t blockers = between_bb[king_square][pop_lsb(&snipers)] & occupied;
+        if (blockers && !more_than_one(blockers))
+            pinned |= blockers & own;
+    }
+
+    uint64_t targets = ~own & check_mask & type_mask;
+
+    moves = generate_pawn_moves(pos, moves, type, position_pieces(pos, us, PAWN) & from_mask, check_mask, pinned, king_square);
+
+    // a pinned knight can never move
+    uint64_t knights = position_pieces(pos, us, KNIGHT) & ~pinned & from_mask;
+    while (knights) {
+        int from = pop_lsb(&knights);
+        moves = add_moves(moves, from, knight_attacks[from] & targets);
+    }
+
+    uint64_t bishops = (position_pieces(pos, us, BISHOP) | position_pieces(pos, us, QUEEN)) & from_mask;
+    while (bishops) {
+        int from = pop_lsb(&bishops);
+        uint64_t b = bishop_attacks(from, occupied) & targets;
+        if (pinned & square_bb(from))
+            b &= line_bb[king_square][from];
+        moves = add_moves(moves, from, b);
+    }
+
+    uint64_t rooks = (position_pieces(pos, us, ROOK) | position_pieces(pos, us, QUEEN)) & from_mask;
+    while (rooks) {
+        int from = pop_lsb(&rooks);
+        uint64_t b = rook_attacks(from, occupied) & targets;
+        if (pinned & square_bb(from))
+            b &= line_bb[king_square][from];
+        moves = add_moves(moves, from, b);
+    }
+
+    if (!checkers && type != GEN_NOISY && (from_mask & square_bb(king_square)))
+        moves = generate_castling(pos, moves);
+
+    return (int)(moves - list);
+}
+
+void generate_moves(const struct position *pos, struct move_list *list, enum gen_type type)
+{
+    list->count = generate(pos, list->moves, type, ~0ULL);
+}
+
+void generate_legal_moves(const struct position *pos, struct move_list *list)
+{
+    list->count = generate(pos, list->moves, GEN_ALL, ~0ULL);
+}
+
+int move_gives_check(const struct position *pos, move m)
+{
+    int us = pos->side_to_move;
+    int king = position_king_square(pos, us ^ 1);
+    int from = move_from(m);
+    int to = move_to(m);
+    int flag = move_flag(m);
+    int type = flag == MOVE_PROMOTION ? move_promotion(m) : piece_type(position_piece_at(pos, from));
+
+    uint64_t moved = square_bb(from);
+    uint64_t occupied = (position_occupied(pos) ^ moved) | square_bb(to);
+    if (flag == MOVE_EN_PASSANT) {
+        occupied ^= square_bb(to + (us == WHITE ? -8 : 8));
+    } else if (flag == MOVE_CASTLING) {
+        // only the rook can give check after castling
+        int base = us == WHITE ? A1 : A8;
+        int rook_from = to > from ? base + 7 : base;
+        int rook_to = to > from ? base + 5 : base + 3;
+        occupied = (occupied ^ square_bb(rook_from)) | square_bb(rook_to);
+        moved |= square_bb(rook_from);
+        type = ROOK;
+        to = rook_to;
+    }
+
+    uint64_t direct;
+    switch (type) {
+    case PAWN:   direct = pawn_attacks[us][to]; break;
+    case KNIGHT: direct = knight_attacks[to]; break;
+    case BISHOP: direct = bishop_attacks(to, occupied); break;
+    case ROOK:   direct = rook_attacks(to, occupied); break;
+    case QUEEN:  direct = queen_attacks(to, occupied); break;
+    default:     direct = 0; break;
+    }
+    if (direct & square_bb(king))
+        return 1;
+
+    // discovered: one of our sliders that stayed put now sees the king
+    uint64_t ours = pos->colors[us] & ~moved;
+    uint64_t diagonal = (pos->pieces[BISHOP] | pos->pieces[QUEEN]) & ours;
+    uint64_t straight = (pos->pieces[ROOK] | pos->pieces[QUEEN]) & ours;
+    return (bishop_attacks(king, occupied) & diagonal) || (rook_attacks(king, occupied) & straight);
+}
+
+int move_is_legal(const struct position *pos, move m)
+{
+    if (m == MOVE_NONE)
+        return 0;
+
+    // only the moving piece is generated, so this is cheap enough to verify
+    // hash and killer moves before trying them
+    move moves[MAX_MOVES];
+    int count = generate(pos, moves, GEN_ALL, square_bb(move_from(m)) & pos->colors[pos->side_to_move]);
+    for (int i = 0; i < count; ++i) {
+        if (moves[i] == m)
+            return 1;
+    }
+    return 0;
+}
+
+uint64_t legal_targets(const struct position *pos, int from)
+{
+    move moves[MAX_MOVES];
+    uint64_t targets = 0;
+
+    int count = generate(pos, moves, GEN_ALL, square_bb(from) & pos->colors[pos->side_to_move]);
+    for (int i = 0; i < count; ++i)
+        targets |= square_bb(move_to(moves[i]));
+
+    return targets;
+}
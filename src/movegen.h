@@ -0,0 +1,43 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include <stdint.h>
+
+#include "move.h"
+#include "position.h"
+
+// all pieces of both colours attacking square with the given occupancy
+uint64_t attackers_to(const struct position *pos, int square, uint64_t occupied);
+
+uint64_t position_checkers(const struct position *pos);
+
+enum gen_type {
+    GEN_ALL,
+    GEN_NOISY,   // captures, en passant and all promotions
+    GEN_QUIETS   // everything else, including castling
+};
+
+// Fills list with every legal move. Check and pin masks are computed first
+// so no move has to be made and tested afterwards.
+void generate_legal_moves(const struct position *pos, struct move_list *list);
+
+// only the legal moves of one type, used by the staged move picker
+void generate_moves(const struct position *pos, struct move_list *list, enum gen_type type);
+
+int move_is_legal(const struct position *pos, move m);
+
+// Whether the legal move m checks the opponent, directly or by discovery,
+// decided on the resulting occupancy without making the move.
+int move_gives_check(const struct position *pos, move m);
+
+// whether m would be generated by GEN_NOISY
+static inline int move_is_noisy(const struct position *pos, move m)
+{
+    return position_piece_at(pos, move_to(m)) != NO_PIECE || move_flag(m) == MOVE_PROMOTION
+        || move_flag(m) == MOVE_EN_PASSANT;
+}
+
+// legal destination squares of the piece on from, for target highlighting
+uint64_t legal_targets(const struct position *pos, int from);
+
+#endif
@@ -0,0 +1,192 @@
+#include "movepick.h"
+
+#include "movegen.h"
+#include "see.h"
+
+// most valuable victim first, least valuable attacker as tie break
+static const int victim_values[PIECE_TYPE_COUNT] = { 100, 320, 330, 500, 900, 0 };
+
+void move_picker_init(struct move_picker *picker, const struct position *pos, move tt_move,
+                      const move *killers, const struct quiet_order *order, struct picker_stats *stats)
+{
+    picker->pos = pos;
+    picker->stats = stats;
+    if (order)
+        picker->order = *order;
+    else
+        picker->order = (struct quiet_order){ 0 };
+    picker->tt_move = move_is_legal(pos, tt_move) ? tt_move : MOVE_NONE;
+    picker->refutations[0] = killers ? killers[0] : MOVE_NONE;
+    picker->refutations[1] = killers && killers[1] != killers[0] ? killers[1] : MOVE_NONE;
+    move counter = picker->order.counter_move;
+    if (counter == picker->refutations[0] || counter == picker->refutations[1])
+        counter = MOVE_NONE;
+    picker->refutations[2] = counter;
+    picker->sort_quiets = picker->order.history != NULL;
+    for (int i = 0; i < CONTINUATION_PLIES; ++i)
+        picker->sort_quiets |= picker->order.continuations[i] != NULL;
+    picker->stage = picker->tt_move != MOVE_NONE ? PICK_TT_MOVE : PICK_CAPTURES_INIT;
+    picker->index = 0;
+    picker->captures_only = 0;
+    picker->bad_capture_count = 0;
+
+    if (stats)
+        stats->pickers++;
+}
+
+void move_picker_init_qsearch(struct move_picker *picker, const struct position *pos, struct picker_stats *stats)
+{
+    picker->pos = pos;
+    picker->stats = stats;
+    picker->order = (struct quiet_order){ 0 };
+    picker->tt_move = MOVE_NONE;
+    picker->refutations[0] = picker->refutations[1] = picker->refutations[2] = MOVE_NONE;
+    picker->sort_quiets = 0;
+    picker->stage = PICK_CAPTURES_INIT;
+    picker->index = 0;
+    picker->captures_only = 1;
+    picker->bad_capture_count = 0;
+}
+
+static void score_captures(struct move_picker *picker)
+{
+    const struct position *pos = picker->pos;
+
+    for (int i = 0; i < picker->list.count; ++i) {
+        move m = picker->list.moves[i];
+        int victim = position_piece_at(pos, move_to(m));
+        int attacker = piece_type(position_piece_at(pos, move_from(m)));
+
+        int score = 0;
+        if (victim != NO_PIECE)
+            score = victim_values[piece_type(victim)] * 8;
+        else if (move_flag(m) == MOVE_EN_PASSANT)
+            score = victim_values[PAWN] * 8;
+        if (move_flag(m) == MOVE_PROMOTION)
+            score += victim_values[move_promotion(m)] * 8;
+
+        picker->scores[i] = score - attacker;
+    }
+}
+
+static void score_quiets(struct move_picker *picker)
+{
+    const struct position *pos = picker->pos;
+    const struct quiet_order *order = &picker->order;
+    const int16_t (*butterfly)[64] = order->history ? order->history->butterfly[pos->side_to_move] : NULL;
+
+    for (int i = 0; i < picker->list.count; ++i) {
+        move m = picker->list.moves[i];
+        int from = move_from(m);
+        int to = move_to(m);
+        int piece = position_piece_at(pos, from);
+
+        int score = butterfly ? butterfly[from][to] : 0;
+        for (int ply = 0; ply < CONTINUATION_PLIES; ++ply) {
+            if (order->continuations[ply])
+                score += (*order->continuations[ply])[piece][to];
+        }
+
+        picker->scores[i] = score;
+    }
+}
+
+// selection sort step: the list is rarely consumed completely before a cutoff
+static move pick_best(struct move_picker *picker)
+{
+    int best = picker->index;
+    for (int i = picker->index + 1; i < picker->list.count; ++i) {
+        if (picker->scores[i] > picker->scores[best])
+            best = i;
+    }
+
+    move m = picker->list.moves[best];
+    int score = picker->scores[best];
+    picker->list.moves[best] = picker->list.moves[picker->index];
+    picker->scores[best] = picker->scores[picker->index];
+    picker->list.moves[picker->index] = m;
+    picker->scores[picker->index] = score;
+
+    picker->index++;
+    return m;
+}
+
+static int is_refutation(const struct move_picker *picker, move m)
+{
+    return m == picker->refutations[0] || m == picker->refutations[1] || m == picker->refutations[2];
+}
+
+move move_picker_next(struct move_picker *picker)
+{
+    switch (picker->stage) {
+    case PICK_TT_MOVE:
+        picker->stage = PICK_CAPTURES_INIT;
+        return picker->tt_move;
+
+    case PICK_CAPTURES_INIT:
+        generate_moves(picker->pos, &picker->list, GEN_NOISY);
+        score_captures(picker);
+        picker->index = 0;
+        picker->stage = PICK_CAPTURES;
+        // fallthrough
+
+    case PICK_CAPTURES:
+        while (picker->index < picker->list.count) {
+            move m = pick_best(picker);
+            if (m == picker->tt_move)
+                continue;
+            // SEE is only computed for captures that are actually reached
+            if (see(picker->pos, m) >= 0)
+                return m;
+            if (!picker->captures_only)
+                picker->bad_captures[picker->bad_capture_count++] = m;
+        }
+        if (picker->captures_only) {
+            picker->stage = PICK_DONE;
+            return MOVE_NONE;
+        }
+        picker->index = 0;
+        picker->stage = PICK_REFUTATIONS;
+        // fallthrough
+
+    case PICK_REFUTATIONS:
+        while (picker->index < 3) {
+            move m = picker->refutations[picker->index++];
+            if (m != MOVE_NONE && m != picker->tt_move && !move_is_noisy(picker->pos, m)
+                && move_is_legal(picker->pos, m))
+                return m;
+        }
+        picker->stage = PICK_QUIETS_INIT;
+        // fallthrough
+
+    case PICK_QUIETS_INIT:
+        generate_moves(picker->pos, &picker->list, GEN_QUIETS);
+        if (picker->stats)
+            picker->stats->quiet_generations++;
+        if (picker->sort_quiets)
+            score_quiets(picker);
+        picker->index = 0;
+        picker->stage = PICK_QUIETS;
+        // fallthrough
+
+    case PICK_QUIETS:
+        while (picker->index < picker->list.count) {
+            move m = picker->sort_quiets ? pick_best(picker) : picker->list.moves[picker->index++];
+            if (m != picker->tt_move && !is_refutation(picker, m))
+                return m;
+        }
+        picker->index = 0;
+        picker->stage = PICK_BAD_CAPTURES;
+        // fallthrough
+
+    case PICK_BAD_CAPTURES:
+        if (picker->index < picker->bad_capture_count)
+            return picker->bad_captures[picker->index++];
+        picker->stage = PICK_DONE;
+        // fallthrough
+
+    case PICK_DONE:
+    default:
+        return MOVE_NONE;
+    }
+}
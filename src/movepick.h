@@ -0,0 +1,69 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include <stdint.h>
+
+#include "history.h"
+#include "move.h"
+#include "position.h"
+
+// counts how often the picker got past the captures, a cutoff before that
+// point means the quiet moves were never generated
+struct picker_stats {
+    uint64_t pickers;
+    uint64_t quiet_generations;
+};
+
+enum pick_stage {
+    PICK_TT_MOVE,
+    PICK_CAPTURES_INIT,
+    PICK_CAPTURES,
+    PICK_REFUTATIONS,
+    PICK_QUIETS_INIT,
+    PICK_QUIETS,
+    PICK_BAD_CAPTURES,
+    PICK_DONE
+};
+
+// What the search has learned about quiet moves at a node. history may be
+// NULL, then the quiet moves come in generation order; continuation
+// entries are NULL where the earlier ply is unknown.
+struct quiet_order {
+    const struct move_history *history;
+    const piece_to_history *continuations[CONTINUATION_PLIES];
+    move counter_move;
+};
+
+// Staged move picker for search. Moves are handed out in the order hash
+// move, winning and equal captures by MVV-LVA, killers and the countermove,
+// the remaining quiet moves by history score and finally captures that
+// lose material by SEE. Each group is only generated once the previous one
+// is exhausted.
+struct move_picker {
+    const struct position *pos;
+    struct picker_stats *stats;
+    struct quiet_order order;
+    move tt_move;
+    move refutations[3];  // two killers and the countermove
+    int stage;
+    int index;
+    int captures_only;
+    int sort_quiets;
+    struct move_list list;
+    int scores[MAX_MOVES];
+    int bad_capture_count;
+    move bad_captures[MAX_MOVES];
+};
+
+// killers, order and stats may be NULL
+void move_picker_init(struct move_picker *picker, const struct position *pos, move tt_move,
+                      const move *killers, const struct quiet_order *order, struct picker_stats *stats);
+
+// Quiescence search picker: only the captures and promotions that don't
+// lose material by SEE, best first. Use the full picker when in check.
+void move_picker_init_qsearch(struct move_picker *picker, const struct position *pos, struct picker_stats *stats);
+
+// returns MOVE_NONE once every legal move has been returned
+move move_picker_next(struct move_picker *picker);
+
+#endif
@@ -0,0 +1,221 @@
+#define _GNU_SOURCE
+#include "numa_nodes.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef CHESS_HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+int node_interleave_tables;
+
+#ifdef __linux__
+#define HAVE_AFFINITY 1
+#endif
+
+static struct {
+    int count;
+    int node_ids[NODE_MAX];  // system node number of each node used here
+    int cpu_counts[NODE_MAX];
+    int total_cpus;
+#ifdef HAVE_AFFINITY
+    cpu_set_t cpus[NODE_MAX];
+#endif
+    const char *source;
+} topology;
+
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+#ifdef HAVE_AFFINITY
+static void add_node(int id, const cpu_set_t *cpus)
+{
+    int count = CPU_COUNT(cpus);
+    if (count == 0 || topology.count == NODE_MAX)
+        return;
+
+    topology.node_ids[topology.count] = id;
+    topology.cpus[topology.count] = *cpus;
+    topology.cpu_counts[topology.count] = count;
+    topology.total_cpus += count;
+    topology.count++;
+}
+
+#ifdef CHESS_HAVE_LIBNUMA
+static int read_libnuma(void)
+{
+    if (numa_available() < 0)
+        return 0;
+
+    struct bitmask *mask = numa_allocate_cpumask();
+    for (int id = 0; id <= numa_max_node(); ++id) {
+        if (numa_node_to_cpus(id, mask) != 0)
+            continue;
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (unsigned cpu = 0; cpu < mask->size && cpu < CPU_SETSIZE; ++cpu) {
+            if (numa_bitmask_isbitset(mask, cpu))
+                CPU_SET(cpu, &cpus);
+        }
+        add_node(id, &cpus);
+    }
+    numa_free_cpumask(mask);
+
+    return topology.count > 0;
+}
+#endif
+
+// cpulist files look like "0-15,32-47"
+static int read_sysfs(void)
+{
+    for (int id = 0; id < NODE_MAX; ++id) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+        FILE *file = fopen(path, "r");
+        if (!file)
+            continue;
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        int first, last;
+        char separator;
+        while (fscanf(file, "%d", &first) == 1) {
+            last = first;
+            separator = (char)fgetc(file);
+            if (separator == '-') {
+                if (fscanf(file, "%d", &last) != 1)
+                    break;
+                separator = (char)fgetc(file);
+            }
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+                CPU_SET(cpu, &cpus);
+            if (separator != ',')
+                break;
+        }
+        fclose(file);
+
+        add_node(id, &cpus);
+    }
+
+    return topology.count > 0;
+}
+#endif
+
+static void read_topology(void)
+{
+#ifdef HAVE_AFFINITY
+#ifdef CHESS_HAVE_LIBNUMA
+    topology.source = "libnuma";
+    if (read_libnuma())
+        return;
+#endif
+    topology.source = "sysfs";
+    if (read_sysfs())
+        return;
+#endif
+
+    topology.source = "none";
+    topology.count = 1;
+    topology.node_ids[0] = 0;
+    topology.cpu_counts[0] = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (topology.cpu_counts[0] < 1)
+        topology.cpu_counts[0] = 1;
+    topology.total_cpus = topology.cpu_counts[0];
+#ifdef HAVE_AFFINITY
+    sched_getaffinity(0, sizeof(topology.cpus[0]), &topology.cpus[0]);
+#endif
+}
+
+void node_select_interleave(int enabled)
+{
+    node_interleave_tables = enabled;
+}
+
+int node_count(void)
+{
+    pthread_once(&topology_once, read_topology);
+    return topology.count;
+}
+
+int node_for_thread(int index)
+{
+    pthread_once(&topology_once, read_topology);
+
+    int cpu = index % topology.total_cpus;
+    for (int node = 0; node < topology.count; ++node) {
+        if (cpu < topology.cpu_counts[node])
+            return node;
+        cpu -= topology.cpu_counts[node];
+    }
+    return 0;
+}
+
+int node_bind_thread(int node)
+{
+    pthread_once(&topology_once, read_topology);
+
+#ifdef HAVE_AFFINITY
+    if (node >= 0 && node < topology.count
+        && sched_setaffinity(0, sizeof(topology.cpus[node]), &topology.cpus[node]) == 0)
+        return 0;
+#else
+    (void)node;
+#endif
+    return -1;
+}
+
+void *node_alloc(size_t size, int node)
+{
+    pthread_once(&topology_once, read_topology);
+
+#ifdef CHESS_HAVE_LIBNUMA
+    if (topology.count > 1 && numa_available() >= 0) {
+        void *memory = numa_alloc_onnode(size, topology.node_ids[node]);
+        if (memory)
+            memset(memory, 0, size);
+        return memory;
+    }
+#else
+    (void)node;
+#endif
+    return calloc(1, size);
+}
+
+void node_free(void *memory, size_t size)
+{
+    if (!memory)
+        return;
+
+#ifdef CHESS_HAVE_LIBNUMA
+    // same condition as node_alloc, the topology doesn't change in between
+    if (topology.count > 1 && numa_available() >= 0) {
+        numa_free(memory, size);
+        return;
+    }
+#else
+    (void)size;
+#endif
+    free(memory);
+}
+
+void node_interleave(void *memory, size_t size)
+{
+#ifdef CHESS_HAVE_LIBNUMA
+    if (node_count() > 1 && numa_available() >= 0)
+        numa_interleave_memory(memory, size, numa_all_nodes_ptr);
+#else
+    (void)memory;
+    (void)size;
+#endif
+}
+
+const char *node_topology_source(void)
+{
+    pthread_once(&topology_once, read_topology);
+    return topology.source;
+}
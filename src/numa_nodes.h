@@ -0,0 +1,38 @@
+#ifndef NUMA_NODES_H
+#define NUMA_NODES_H
+
+#include <stddef.h>
+
+// NUMA placement for the search. The topology comes from libnuma when the
+// build found it (CHESS_HAVE_LIBNUMA), from sysfs otherwise, and is a
+// single node where neither is available. Prefixed node_ to stay clear of
+// the libnuma names.
+
+#define NODE_MAX 64
+
+// interleave large shared tables over all nodes, off by default
+extern int node_interleave_tables;
+
+void node_select_interleave(int enabled);
+
+int node_count(void);
+
+// Node for search thread index. Nodes are filled one after another so a
+// few threads share one node's caches, wrapping once every core is used.
+int node_for_thread(int index);
+
+// Pins the calling thread to the cores of node. Returns -1 if that isn't
+// supported, the thread then keeps running wherever the scheduler puts it.
+int node_bind_thread(int node);
+
+// zeroed memory on node, falls back to a normal allocation
+void *node_alloc(size_t size, int node);
+void node_free(void *memory, size_t size);
+
+// spread the pages of memory over all nodes, does nothing without libnuma
+void node_interleave(void *memory, size_t size);
+
+// "libnuma", "sysfs" or "none"
+const char *node_topology_source(void);
+
+#endif
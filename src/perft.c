@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "attacks.h"
+#include "fen.h"
+#include "movegen.h"
+#include "position.h"
+
+// Shared perft hash. Entries are written without locks, the key is stored
+// xor'ed with the node count so a torn entry fails verification.
+struct perft_entry {
+    _Atomic uint64_t check;
+    _Atomic uint64_t nodes;
+};
+
+static struct perft_entry *hash_table;
+static uint64_t hash_mask;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t perft(struct position *pos, struct undo_stack *stack, int depth)
+{
+    struct move_list list;
+    generate_legal_moves(pos, &list);
+
+    // bulk counting: the leaves are never made
+    if (depth == 1)
+        return (uint64_t)list.count;
+
+    uint64_t key = 0;
+    struct perft_entry *entry = NULL;
+    if (hash_table) {
+        // the depth is folded in so one table serves every remaining depth
+        key = pos->key ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ULL);
+        entry = &hash_table[key & hash_mask];
+
+        uint64_t nodes = atomic_load_explicit(&entry->nodes, memory_order_relaxed);
+        if ((atomic_load_explicit(&entry->check, memory_order_relaxed) ^ nodes) == key)
+            return nodes;
+    }
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < list.count; ++i) {
+#ifdef CHESS_COPY_MAKE
+        struct position child;
+        position_copy_make(pos, &child, list.moves[i]);
+        nodes += perft(&child, stack, depth - 1);
+#else
+        position_make_move(pos, stack, list.moves[i]);
+        nodes += perft(pos, stack, depth - 1);
+        position_unmake_move(pos, stack, list.moves[i]);
+#endif
+    }
+
+    if (entry) {
+        atomic_store_explicit(&entry->check, key ^ nodes, memory_order_relaxed);
+        atomic_store_explicit(&entry->nodes, nodes, memory_order_relaxed);
+    }
+
+    return nodes;
+}
+
+// root moves are handed out to the worker threads one at a time
+struct root_split {
+    const struct position *pos;
+    struct move_list moves;
+    uint64_t nodes[MAX_MOVES];
+    int depth;
+    atomic_int next;
+};
+
+static void *root_worker(void *arg)
+{
+    struct root_split *split = arg;
+    struct undo_stack stack = { 0 };
+
+    for (;;) {
+        int i = atomic_fetch_add(&split->next, 1);
+        if (i >= split->moves.count)
+            break;
+
+        struct position child;
+        position_copy_make(split->pos, &child, split->moves.moves[i]);
+        split->nodes[i] = split->depth > 1 ? perft(&child, &stack, split->depth - 1) : 1;
+    }
+
+    return NULL;
+}
+
+static uint64_t perft_root(const struct position *pos, int depth, int threads, int divide)
+{
+    if (depth == 0)
+        return 1;
+
+    static struct root_split split;
+    split.pos = pos;
+    split.depth = depth;
+    atomic_store(&split.next, 0);
+    generate_legal_moves(pos, &split.moves);
+
+    pthread_t workers[256];
+    if (threads > 256)
+        threads = 256;
+    for (int i = 1; i < threads; ++i)
+        pthread_create(&workers[i], NULL, root_worker, &split);
+    root_worker(&split);
+    for (int i = 1; i < threads; ++i)
+        pthread_join(workers[i], NULL);
+
+    uint64_t total = 0;
+    for (int i = 0; i < split.moves.count; ++i) {
+        if (divide) {
+            char uci[6];
+            move_to_uci(split.moves.moves[i], uci);
+            printf("%s: %llu\n", uci, (unsigned long long)split.nodes[i]);
+        }
+        total += split.nodes[i];
+    }
+
+    return total;
+}
+
+struct suite_position {
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// reference positions and node counts from the Chess Programming Wiki
+static const struct suite_position suite[] = {
+    { "startpos",  START_FEN, 6, 119060324ULL },
+    { "kiwipete",  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690ULL },
+    { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661ULL },
+    { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL },
+    { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194ULL },
+    { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551ULL },
+};
+
+static int run_suite(int threads)
+{
+    uint64_t total_nodes = 0;
+    double total_time = 0.0;
+    int failures = 0;
+
+    for (size_t i = 0; i < sizeof(suite) / sizeof(suite[0]); ++i) {
+        struct position pos;
+        position_set_fen(&pos, suite[i].fen);
+
+        double start = now_seconds();
+        uint64_t nodes = perft_root(&pos, suite[i].depth, threads, 0);
+        double elapsed = now_seconds() - start;
+
+        int passed = nodes == suite[i].nodes;
+        failures += !passed;
+        total_nodes += nodes;
+        total_time += elapsed;
+
+        printf("%-10s depth %d %12llu nodes %8.3f s %10.1f Mnps  %s\n", suite[i].name, suite[i].depth,
+               (unsigned long long)nodes, elapsed, nodes / elapsed / 1e6, passed ? "ok" : "FAILED");
+    }
+
+    printf("total %llu nodes in %.3f s, %.1f Mnps\n", (unsigned long long)total_nodes, total_time,
+           total_nodes / total_time / 1e6);
+
+    return failures ? -1 : 0;
+}
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options] <depth>\n", program);
+    printf("       %s [options] --suite\n", program);
+    printf("  --fen <fen>      position to count (default: start position)\n");
+    printf("  --divide         print the node count below every root move\n");
+    printf("  --threads <n>    split the root moves over n threads (default: all cores)\n");
+    printf("  --hash <mb>      size of the shared perft hash table (default: off)\n");
+    printf("  --suite          run the standard perft positions and report nodes per second\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *fen = START_FEN;
+    int depth = -1;
+    int divide = 0;
+    int suite_mode = 0;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    size_t hash_mb = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (strcmp(argv[i], "--divide") == 0) {
+            divide = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hash_mb = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--suite") == 0) {
+            suite_mode = 1;
+        } else if (argv[i][0] >= '0' && argv[i][0] <= '9') {
+            depth = atoi(argv[i]);
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (depth < 0 && !suite_mode) {
+        print_usage(argv[0]);
+        return -1;
+    }
+    if (threads < 1)
+        threads = 1;
+
+    attacks_init();
+
+    if (hash_mb) {
+        // round down to a power of two number of entries
+        size_t entries = 1;
+        while (entries * 2 * sizeof(struct perft_entry) <= hash_mb * 1024 * 1024)
+            entries *= 2;
+
+        hash_table = calloc(entries, sizeof(struct perft_entry));
+        if (!hash_table) {
+            printf("Error: failed to allocate %zu MB perft hash\n", hash_mb);
+            return -1;
+        }
+        hash_mask = entries - 1;
+    }
+
+    if (suite_mode)
+        return run_suite(threads);
+
+    struct position pos;
+    if (position_set_fen(&pos, fen) != 0) {
+        printf("Error: invalid FEN - %s\n", fen);
+        return -1;
+    }
+
+    double start = now_seconds();
+    uint64_t nodes = perft_root(&pos, depth, threads, divide);
+    double elapsed = now_seconds() - start;
+
+    printf("\nNodes: %llu\nTime: %.3f s\nNPS: %.0f\n", (unsigned long long)nodes, elapsed, nodes / elapsed);
+
+    free(hash_table);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "position.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "attacks.h"
+
+// castling rights lost when a piece moves from or to each square
+static const uint8_t castling_lost[64] = {
+    [A1] = CASTLE_WHITE_QUEEN, [E1] = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN, [H1] = CASTLE_WHITE_KING,
+    [A8] = CASTLE_BLACK_QUEEN, [E8] = CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN, [H8] = CASTLE_BLACK_KING,
+};
+
+void position_clear(struct position *pos)
+{
+    memset(pos, 0, sizeof(*pos));
+    pos->en_passant = NO_SQUARE;
+    pos->fullmove_number = 1;
+}
+
+uint64_t position_compute_key(const struct position *pos)
+{
+    uint64_t key = 0;
+
+    for (int square = 0; square < 64; ++square)
+        key ^= zobrist_pieces[position_piece_at(pos, square)][square];
+
+    key ^= zobrist_castling[pos->castling_rights];
+    if (pos->en_passant != NO_SQUARE)
+        key ^= zobrist_en_passant[square_file(pos->en_passant)];
+    if (pos->side_to_move == BLACK)
+        key ^= zobrist_side;
+
+    return key;
+}
+
+// shared by make and copy-make, returns the captured piece
+static inline int apply_move(struct position *pos, move m)
+{
+    int from = move_from(m);
+    int to = move_to(m);
+    int flag = move_flag(m);
+    int us = pos->side_to_move;
+    int them = us ^ 1;
+    int piece = position_piece_at(pos, from);
+    int captured = position_piece_at(pos, to);
+
+    pos->halfmove_clock++;
+    if (pos->en_passant != NO_SQUARE) {
+        pos->key ^= zobrist_en_passant[square_file(pos->en_passant)];
+        pos->en_passant = NO_SQUARE;
+    }
+
+    if (flag == MOVE_EN_PASSANT) {
+        captured = make_piece(them, PAWN);
+        position_remove_piece(pos, to + (us == WHITE ? -8 : 8));
+    } else if (flag == MOVE_CASTLING) {
+        // the rook jumps over the king from its corner
+        int base = us == WHITE ? A1 : A8;
+        int rook_from = to > from ? base + 7 : base;
+        int rook_to   = to > from ? base + 5 : base + 3;
+        position_remove_piece(pos, rook_from);
+        position_put_piece(pos, make_piece(us, ROOK), rook_to);
+    } else if (captured != NO_PIECE) {
+        position_remove_piece(pos, to);
+    }
+
+    if (captured != NO_PIECE)
+        pos->halfmove_clock = 0;
+
+    position_remove_piece(pos, from);
+    position_put_piece(pos, flag == MOVE_PROMOTION ? make_piece(us, move_promotion(m)) : piece, to);
+
+    if (piece_type(piece) == PAWN) {
+        pos->halfmove_clock = 0;
+
+        // only record en passant when it can actually be captured
+        int skipped = (from + to) / 2;
+        if ((to ^ from) == 16 && (pawn_attacks[us][skipped] & position_pieces(pos, them, PAWN))) {
+            pos->en_passant = (uint8_t)skipped;
+            pos->key ^= zobrist_en_passant[square_file(skipped)];
+        }
+    }
+
+    pos->key ^= zobrist_castling[pos->castling_rights];
+    pos->castling_rights &= (uint8_t)~(castling_lost[from] | castling_lost[to]);
+    pos->key ^= zobrist_castling[pos->castling_rights];
+
+    pos->side_to_move = (uint8_t)them;
+    pos->key ^= zobrist_side;
+    if (us == BLACK)
+        pos->fullmove_number++;
+
+    return captured;
+}
+
+void position_make_move(struct position *pos, struct undo_stack *stack, move m)
+{
+    assert(stack->count < UNDO_STACK_SIZE);
+    struct undo *undo = &stack->entries[stack->count++];
+
+    undo->key = pos->key;
+    undo->castling_rights = pos->castling_rights;
+    undo->en_passant = pos->en_passant;
+    undo->halfmove_clock = pos->halfmove_clock;
+    undo->captured = (uint8_t)apply_move(pos, m);
+
+    assert(pos->key == position_compute_key(pos));
+}
+
+void position_unmake_move(struct position *pos, struct undo_stack *stack, move m)
+{
+    const struct undo *undo = &stack->entries[--stack->count];
+    int from = move_from(m);
+    int to = move_to(m);
+    int flag = move_flag(m);
+    int them = pos->side_to_move;
+    int us = them ^ 1;
+
+    pos->side_to_move = (uint8_t)us;
+    if (us == BLACK)
+        pos->fullmove_number--;
+
+    int piece = position_piece_at(pos, to);
+    position_remove_piece(pos, to);
+    position_put_piece(pos, flag == MOVE_PROMOTION ? make_piece(us, PAWN) : piece, from);
+
+    if (flag == MOVE_EN_PASSANT) {
+        position_put_piece(pos, undo->captured, to + (us == WHITE ? -8 : 8));
+    } else if (flag == MOVE_CASTLING) {
+        int base = us == WHITE ? A1 : A8;
+        int rook_from = to > from ? base + 7 : base;
+        int rook_to   = to > from ? base + 5 : base + 3;
+        position_remove_piece(pos, rook_to);
+        position_put_piece(pos, make_piece(us, ROOK), rook_from);
+    } else if (undo->captured != NO_PIECE) {
+        position_put_piece(pos, undo->captured, to);
+    }
+
+    // the piece updates above also toggled the key, restoring it is cheaper
+    // than undoing the remaining terms
+    pos->key = undo->key;
+    pos->castling_rights = undo->castling_rights;
+    pos->en_passant = undo->en_passant;
+    pos->halfmove_clock = undo->halfmove_clock;
+}
+
+void position_make_null_move(struct position *pos, struct undo_stack *stack)
+{
+    assert(stack->count < UNDO_STACK_SIZE);
+    struct undo *undo = &stack->entries[stack->count++];
+
+    undo->key = pos->key;
+    undo->castling_rights = pos->castling_rights;
+    undo->en_passant = pos->en_passant;
+    undo->halfmove_clock = pos->halfmove_clock;
+    undo->captured = NO_PIECE;
+
+    if (pos->en_passant != NO_SQUARE) {
+        pos->key ^= zobrist_en_passant[square_file(pos->en_passant)];
+        pos->en_passant = NO_SQUARE;
+    }
+    pos->halfmove_clock = 0;
+    pos->side_to_move ^= 1;
+    pos->key ^= zobrist_side;
+
+    assert(pos->key == position_compute_key(pos));
+}
+
+void position_unmake_null_move(struct position *pos, struct undo_stack *stack)
+{
+    const struct undo *undo = &stack->entries[--stack->count];
+
+    pos->side_to_move ^= 1;
+    pos->key = undo->key;
+    pos->en_passant = undo->en_passant;
+    pos->halfmove_clock = undo->halfmove_clock;
+}
+
+void position_copy_make(const struct position *pos, struct position *child, move m)
+{
+    *child = *pos;
+    apply_move(child, m);
+
+    assert(child->key == position_compute_key(child));
+}
@@ -0,0 +1,167 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <stdint.h>
+
+#include "bitboard.h"
+#include "move.h"
+#include "zobrist.h"
+
+enum color { WHITE, BLACK };
+
+enum piece_type { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, PIECE_TYPE_COUNT };
+
+// piece = (color << 3) | (type + 1) so that 0 means an empty square and
+// every piece fits in a nibble of the mailbox
+enum piece {
+    NO_PIECE,
+    WHITE_PAWN = 1, WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN, WHITE_KING,
+    BLACK_PAWN = 9, BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN, BLACK_KING,
+    PIECE_COUNT = 16
+};
+
+enum square {
+    A1, B1, C1, D1, E1, F1, G1, H1,
+    A2, B2, C2, D2, E2, F2, G2, H2,
+    A3, B3, C3, D3, E3, F3, G3, H3,
+    A4, B4, C4, D4, E4, F4, G4, H4,
+    A5, B5, C5, D5, E5, F5, G5, H5,
+    A6, B6, C6, D6, E6, F6, G6, H6,
+    A7, B7, C7, D7, E7, F7, G7, H7,
+    A8, B8, C8, D8, E8, F8, G8, H8,
+    NO_SQUARE
+};
+
+enum castling_rights {
+    CASTLE_WHITE_KING  = 1,
+    CASTLE_WHITE_QUEEN = 2,
+    CASTLE_BLACK_KING  = 4,
+    CASTLE_BLACK_QUEEN = 8
+};
+
+// Core game state, independent of rendering. The bitboards fill the first
+// cache line and the nibble packed mailbox plus the remaining state fill the
+// second one.
+struct position {
+    _Alignas(64) uint64_t pieces[PIECE_TYPE_COUNT];
+    uint64_t colors[2];
+
+    uint8_t board[32];  // two squares per byte, even squares in the low nibble
+    uint8_t side_to_move;
+    uint8_t castling_rights;
+    uint8_t en_passant;  // NO_SQUARE when no capture is possible
+    uint8_t halfmove_clock;
+    uint16_t fullmove_number;
+    uint64_t key;  // Zobrist hash, maintained incrementally
+};
+
+_Static_assert(sizeof(struct position) == 128, "position must fit in two cache lines");
+
+static inline int make_piece(int color, int type)
+{
+    return (color << 3) | (type + 1);
+}
+
+static inline int piece_type(int piece)
+{
+    return (piece & 7) - 1;
+}
+
+static inline int piece_color(int piece)
+{
+    return piece >> 3;
+}
+
+static inline int square_file(int square)
+{
+    return square & 7;
+}
+
+static inline int square_rank(int square)
+{
+    return square >> 3;
+}
+
+static inline int make_square(int file, int rank)
+{
+    return (rank << 3) | file;
+}
+
+static inline int position_piece_at(const struct position *pos, int square)
+{
+    return (pos->board[square >> 1] >> ((square & 1) << 2)) & 0xF;
+}
+
+static inline uint64_t position_occupied(const struct position *pos)
+{
+    return pos->colors[WHITE] | pos->colors[BLACK];
+}
+
+static inline uint64_t position_pieces(const struct position *pos, int color, int type)
+{
+    return pos->pieces[type] & pos->colors[color];
+}
+
+static inline int position_king_square(const struct position *pos, int color)
+{
+    return lsb(position_pieces(pos, color, KING));
+}
+
+static inline void position_put_piece(struct position *pos, int piece, int square)
+{
+    uint64_t bb = square_bb(square);
+    int shift = (square & 1) << 2;
+
+    pos->pieces[piece_type(piece)] |= bb;
+    pos->colors[piece_color(piece)] |= bb;
+    pos->key ^= zobrist_pieces[piece][square];
+    pos->board[square >> 1] = (uint8_t)((pos->board[square >> 1] & ~(0xF << shift)) | (piece << shift));
+}
+
+static inline void position_remove_piece(struct position *pos, int square)
+{
+    int piece = position_piece_at(pos, square);
+    uint64_t bb = square_bb(square);
+
+    pos->pieces[piece_type(piece)] &= ~bb;
+    pos->colors[piece_color(piece)] &= ~bb;
+    pos->key ^= zobrist_pieces[piece][square];
+    pos->board[square >> 1] &= (uint8_t)~(0xF << ((square & 1) << 2));
+}
+
+void position_clear(struct position *pos);
+
+// Zobrist key of the position computed from scratch, used to verify the
+// incremental key in debug builds
+uint64_t position_compute_key(const struct position *pos);
+
+// state that cannot be recovered from the move when it is taken back
+struct undo {
+    uint64_t key;
+    uint8_t captured;
+    uint8_t castling_rights;
+    uint8_t en_passant;
+    uint8_t halfmove_clock;
+};
+
+// preallocated so making a move never touches the heap
+#define UNDO_STACK_SIZE 1024
+
+struct undo_stack {
+    int count;
+    struct undo entries[UNDO_STACK_SIZE];
+};
+
+// make/unmake update the position incrementally and push/pop one undo record
+void position_make_move(struct position *pos, struct undo_stack *stack, move m);
+void position_unmake_move(struct position *pos, struct undo_stack *stack, move m);
+
+// Passes the move to the opponent, for null-move pruning. The halfmove
+// clock restarts so repetition checks don't look back across the null move.
+void position_make_null_move(struct position *pos, struct undo_stack *stack);
+void position_unmake_null_move(struct position *pos, struct undo_stack *stack);
+
+// copy-make: writes the position after m to child and leaves pos untouched
+void position_copy_make(const struct position *pos, struct position *child, move m);
+
+#endif
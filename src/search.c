@@ -0,0 +1,937 @@
+#include "search.h"
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "evaluate.h"
+#include "history.h"
+#include "movegen.h"
+#include "numa_nodes.h"
+
+// the time is only looked at every few thousand nodes
+#define CHECK_INTERVAL 2048
+
+// selectivity, margins are in centipawns per ply of remaining depth
+#define REVERSE_FUTILITY_DEPTH  6
+#define REVERSE_FUTILITY_MARGIN 90
+#define FUTILITY_DEPTH          6
+#define FUTILITY_MARGIN         100
+#define NULL_MOVE_DEPTH         3
+#define NULL_MOVE_VERIFY_DEPTH  12
+#define LMR_DEPTH               3
+#define SINGULAR_DEPTH          8
+#define SINGULAR_MARGIN         3
+
+// With CHESS_COPY_MAKE a move is made on a copy of the position one slot up
+// and unmade by stepping back down, otherwise the one position is updated
+// in place and restored from the undo stack. Null moves always use the
+// undo stack.
+#ifdef CHESS_COPY_MAKE
+#define POSITION_STACK_SIZE (MAX_PLY + 1)
+#else
+#define POSITION_STACK_SIZE 1
+#endif
+
+// The move made from a ply and the continuation history entry it selects,
+// MOVE_NONE and NULL for a null move. excluded is the move a singular
+// search at this ply leaves out.
+struct ply_state {
+    move move;
+    int piece;
+    piece_to_history *continuation;
+    move excluded;
+};
+
+// Everything a thread writes during the search lives here, only the
+// transposition table is shared.
+struct search_thread {
+    struct search *search;
+    int index;
+    int node;
+    pthread_t handle;
+    struct search_result *result;  // main thread only
+    _Atomic uint64_t nodes;  // only written by the owner, read by the main thread for reports
+    struct position *pos;  // the current position, the top of positions
+    struct position positions[POSITION_STACK_SIZE];
+    struct undo_stack stack;
+    // Attack maps along the current line, only kept with options.attack_eval.
+    // A map is built from its parent's and the move in between when it is
+    // first needed, so unmaking a move costs nothing and nodes that are
+    // never evaluated or searched further never build one.
+    int height;         // moves made since the root, null moves included
+    int attacks_valid;  // attacks[0] to attacks[attacks_valid - 1] belong to the current line
+    move attack_moves[MAX_PLY + 1];  // the move to each height, MOVE_NONE for a null move
+    struct attack_map attacks[MAX_PLY + 1];
+    struct key_history history;
+    struct tt_stats tt_stats;
+    struct picker_stats picker_stats;
+    move root_best;
+    int root_depth;  // of the iteration being searched
+    move killers[MAX_PLY][2];
+    struct ply_state plies[MAX_PLY + 1];
+    int null_move_ply;  // no null moves before this ply while verifying one
+    int pv_length[MAX_PLY + 1];
+    move pv[MAX_PLY + 1][MAX_PLY + 1];
+    struct move_history move_history;  // kept from search to search
+};
+
+// Late move reductions by depth and move number, log(depth) * log(moves)
+// grows slowly enough that the first few moves are never reduced much.
+#define LMR_TABLE_SIZE 64
+static int8_t reductions[LMR_TABLE_SIZE][LMR_TABLE_SIZE];
+static pthread_once_t reductions_once = PTHREAD_ONCE_INIT;
+
+static void init_reductions(void)
+{
+    for (int depth = 1; depth < LMR_TABLE_SIZE; ++depth) {
+        for (int moves = 1; moves < LMR_TABLE_SIZE; ++moves)
+            reductions[depth][moves] = (int8_t)(0.75 + log(depth) * log(moves) / 2.25);
+    }
+}
+
+static int late_move_reduction(int depth, int move_count)
+{
+    depth = depth < LMR_TABLE_SIZE ? depth : LMR_TABLE_SIZE - 1;
+    move_count = move_count < LMR_TABLE_SIZE ? move_count : LMR_TABLE_SIZE - 1;
+    return reductions[depth][move_count];
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int search_init(struct search *search, size_t hash_mb, search_report_fn report, void *report_context)
+{
+    memset(search, 0, sizeof(*search));
+    atomic_init(&search->stop, 0);
+    search->report = report;
+    search->report_context = report_context;
+    search->options = (struct search_options){
+        .killers = 1,
+        .history = 1,
+        .countermoves = 1,
+        .continuation_history = 1,
+        .null_move = 1,
+        .late_move_reductions = 1,
+        .reverse_futility = 1,
+        .futility = 1,
+        .singular_extensions = 1,
+        .attack_eval = 1,
+    };
+    pthread_once(&reductions_once, init_reductions);
+
+    if (tt_init(&search->tt, hash_mb) != 0)
+        return -1;
+
+    if (search_set_threads(search, 1) != 0) {
+        tt_free(&search->tt);
+        return -1;
+    }
+
+    return 0;
+}
+
+void search_free(struct search *search)
+{
+    for (int i = 0; i < search->thread_count; ++i)
+        node_free(search->threads[i], sizeof(*search->threads[i]));
+    free(search->threads);
+    search->threads = NULL;
+    search->thread_count = 0;
+    tt_free(&search->tt);
+}
+
+int search_set_threads(struct search *search, int count)
+{
+    if (count < 1)
+        count = 1;
+    if (count > SEARCH_MAX_THREADS)
+        count = SEARCH_MAX_THREADS;
+
+    for (int i = count; i < search->thread_count; ++i)
+        node_free(search->threads[i], sizeof(*search->threads[i]));
+    if (count < search->thread_count)
+        search->thread_count = count;
+
+    struct search_thread **threads = realloc(search->threads, sizeof(*threads) * (size_t)count);
+    if (!threads) {
+        printf("Error: failed to allocate search threads\n");
+        return -1;
+    }
+    search->threads = threads;
+
+    // each thread's stacks and tables live on the node it will run on
+    for (int i = search->thread_count; i < count; ++i) {
+        int node = node_for_thread(i);
+        threads[i] = node_alloc(sizeof(*threads[i]), node);
+        if (!threads[i]) {
+            printf("Error: failed to allocate search thread state\n");
+            return -1;
+        }
+        threads[i]->search = search;
+        threads[i]->index = i;
+        threads[i]->node = node;
+        search->thread_count = i + 1;
+    }
+
+    return 0;
+}
+
+void search_clear(struct search *search)
+{
+    tt_clear(&search->tt);
+    // every thread clears its own tables when the next search starts
+    search->clear_pending = 1;
+}
+
+uint64_t search_thread_nodes(const struct search *search, int index)
+{
+    return atomic_load_explicit(&search->threads[index]->nodes, memory_order_relaxed);
+}
+
+static uint64_t total_nodes(const struct search *search)
+{
+    uint64_t nodes = 0;
+    for (int i = 0; i < search->thread_count; ++i)
+        nodes += search_thread_nodes(search, i);
+    return nodes;
+}
+
+void search_stop(struct search *search)
+{
+    atomic_store_explicit(&search->stop, 1, memory_order_relaxed);
+}
+
+void search_ponderhit(struct search *search)
+{
+    double now = now_seconds();
+    atomic_store(&search->ponderhit_time, now);
+    int move_time_ms = atomic_load(&search->move_time_ms);
+    atomic_store(&search->deadline, move_time_ms > 0 ? now + move_time_ms / 1000.0 : 0.0);
+    atomic_store(&search->pondering, 0);
+}
+
+// the limits are checked by the main thread only, helpers just follow the flag
+static int should_stop(struct search_thread *thread)
+{
+    struct search *search = thread->search;
+    if (atomic_load_explicit(&search->stop, memory_order_relaxed))
+        return 1;
+
+    uint64_t nodes = atomic_load_explicit(&thread->nodes, memory_order_relaxed);
+    if (thread->index == 0 && (nodes % CHECK_INTERVAL) == 0) {
+        if (search->poll) {
+            search->poll(search->report_context);
+            if (atomic_load_explicit(&search->stop, memory_order_relaxed))
+                return 1;
+        }
+        double deadline = atomic_load_explicit(&search->deadline, memory_order_relaxed);
+        if ((search->node_limit && total_nodes(search) >= search->node_limit)
+            || (deadline > 0.0 && now_seconds() >= deadline)) {
+            search_stop(search);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// brings the attack map of the current position up to date
+static const struct attack_map *current_attacks(struct search_thread *thread)
+{
+    int height = thread->height;
+    struct attack_map *map = &thread->attacks[height];
+
+    if (thread->attacks_valid <= height) {
+        // the parent's is valid, it was brought up to date before the move
+        *map = thread->attacks[height - 1];
+        if (thread->attack_moves[height] != MOVE_NONE)
+            attack_map_update(map, thread->pos, thread->attack_moves[height]);
+        thread->attacks_valid = height + 1;
+    }
+    return map;
+}
+
+static int static_eval(struct search_thread *thread)
+{
+    return evaluate(thread->pos, thread->search->options.attack_eval ? current_attacks(thread) : NULL);
+}
+
+// m is MOVE_NONE for a null move
+static void push_height(struct search_thread *thread, move m)
+{
+    if (thread->search->options.attack_eval)
+        current_attacks(thread);
+
+    assert(thread->height < MAX_PLY);
+    thread->height++;
+    thread->attack_moves[thread->height] = m;
+    // a map left at this height belongs to a sibling
+    if (thread->attacks_valid > thread->height)
+        thread->attacks_valid = thread->height;
+}
+
+static void make_move(struct search_thread *thread, move m)
+{
+    push_height(thread, m);
+    key_history_push(&thread->history, thread->pos->key);
+#ifdef CHESS_COPY_MAKE
+    struct position *child = thread->pos + 1;
+    assert(child < thread->positions + POSITION_STACK_SIZE);
+    position_copy_make(thread->pos, child, m);
+    thread->pos = child;
+#else
+    position_make_move(thread->pos, &thread->stack, m);
+#endif
+    tt_prefetch(&thread->search->tt, thread->pos->key);
+    // a plain load and store, nobody else writes the counter
+    atomic_store_explicit(&thread->nodes, atomic_load_explicit(&thread->nodes, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+static void unmake_move(struct search_thread *thread, move m)
+{
+#ifdef CHESS_COPY_MAKE
+    (void)m;
+    thread->pos--;
+#else
+    position_unmake_move(thread->pos, &thread->stack, m);
+#endif
+    thread->height--;
+    key_history_pop(&thread->history);
+}
+
+static void make_null_move(struct search_thread *thread)
+{
+    push_height(thread, MOVE_NONE);
+    key_history_push(&thread->history, thread->pos->key);
+    position_make_null_move(thread->pos, &thread->stack);
+    tt_prefetch(&thread->search->tt, thread->pos->key);
+    atomic_store_explicit(&thread->nodes, atomic_load_explicit(&thread->nodes, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+static void unmake_null_move(struct search_thread *thread)
+{
+    position_unmake_null_move(thread->pos, &thread->stack);
+    thread->height--;
+    key_history_pop(&thread->history);
+}
+
+// pieces other than pawns and the king, without them zugzwang is likely
+static int has_non_pawn_material(const struct position *pos)
+{
+    uint64_t pieces = pos->colors[pos->side_to_move];
+    return (pieces & ~(pos->pieces[PAWN] | pos->pieces[KING])) != 0;
+}
+
+static void set_ply_move(struct search_thread *thread, int ply, move m)
+{
+    struct ply_state *state = &thread->plies[ply];
+    state->move = m;
+    state->piece = position_piece_at(thread->pos, move_from(m));
+    state->continuation = &thread->move_history.continuation[state->piece][move_to(m)];
+}
+
+static void set_ply_null_move(struct search_thread *thread, int ply)
+{
+    struct ply_state *state = &thread->plies[ply];
+    state->move = MOVE_NONE;
+    state->piece = NO_PIECE;
+    state->continuation = NULL;
+}
+
+// continuation history entry of the move made back plies before ply
+static piece_to_history *ply_continuation(const struct search_thread *thread, int ply, int back)
+{
+    return ply >= back ? thread->plies[ply - back].continuation : NULL;
+}
+
+static void order_quiets(const struct search_thread *thread, int ply, struct quiet_order *order)
+{
+    const struct search_options *options = &thread->search->options;
+    *order = (struct quiet_order){ 0 };
+
+    if (options->history)
+        order->history = &thread->move_history;
+    if (options->countermoves && ply > 0 && thread->plies[ply - 1].move != MOVE_NONE) {
+        const struct ply_state *previous = &thread->plies[ply - 1];
+        order->counter_move = thread->move_history.countermoves[previous->piece][move_to(previous->move)];
+    }
+    if (options->continuation_history) {
+        for (int i = 0; i < CONTINUATION_PLIES; ++i)
+            order->continuations[i] = ply_continuation(thread, ply, i + 1);
+    }
+}
+
+// A quiet move caused a beta cutoff: reward it and punish the quiet moves
+// searched before it, which failed to cut.
+static void update_quiet_stats(struct search_thread *thread, int ply, int depth, move best, const move *quiets,
+                               int quiet_count)
+{
+    const struct search_options *options = &thread->search->options;
+    const struct position *pos = thread->pos;
+    struct move_history *history = &thread->move_history;
+
+    if (options->killers && thread->killers[ply][0] != best) {
+        thread->killers[ply][1] = thread->killers[ply][0];
+        thread->killers[ply][0] = best;
+    }
+
+    if (options->countermoves && ply > 0 && thread->plies[ply - 1].move != MOVE_NONE) {
+        const struct ply_state *previous = &thread->plies[ply - 1];
+        history->countermoves[previous->piece][move_to(previous->move)] = best;
+    }
+
+    int bonus = history_bonus(depth);
+    for (int i = 0; i < quiet_count; ++i) {
+        move m = quiets[i];
+        int from = move_from(m);
+        int to = move_to(m);
+        int piece = position_piece_at(pos, from);
+        int amount = m == best ? bonus : -bonus;
+
+        if (options->history)
+            history_update(&history->butterfly[pos->side_to_move][from][to], amount);
+        if (options->continuation_history) {
+            for (int back = 1; back <= CONTINUATION_PLIES; ++back) {
+                piece_to_history *continuation = ply_continuation(thread, ply, back);
+                if (continuation)
+                    history_update(&(*continuation)[piece][to], amount);
+            }
+        }
+    }
+}
+
+static void update_pv(struct search_thread *thread, int ply, move m)
+{
+    int child = ply + 1;
+    thread->pv[ply][0] = m;
+    memcpy(&thread->pv[ply][1], thread->pv[child], sizeof(move) * (size_t)thread->pv_length[child]);
+    thread->pv_length[ply] = thread->pv_length[child] + 1;
+}
+
+// mate scores are stored relative to the node, not to the root
+static int score_to_tt(int score, int ply)
+{
+    if (score >= SCORE_MATE_IN_MAX)
+        return score + ply;
+    if (score <= -SCORE_MATE_IN_MAX)
+        return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply)
+{
+    if (score >= SCORE_MATE_IN_MAX)
+        return score - ply;
+    if (score <= -SCORE_MATE_IN_MAX)
+        return score + ply;
+    return score;
+}
+
+static int tt_cutoff(const struct tt_data *entry, int score, int alpha, int beta)
+{
+    return entry->bound == BOUND_EXACT
+        || (entry->bound == BOUND_LOWER && score >= beta)
+        || (entry->bound == BOUND_UPPER && score <= alpha);
+}
+
+static int is_draw(const struct search_thread *thread)
+{
+    // a single repetition inside the search is treated as a draw, the
+    // opponent can always repeat once more
+    return position_draw_state(thread->pos, &thread->history, 1) != DRAW_NONE;
+}
+
+static int qsearch(struct search_thread *thread, int ply, int alpha, int beta)
+{
+    struct position *pos = thread->pos;
+    thread->pv_length[ply] = 0;
+
+    if (should_stop(thread))
+        return 0;
+    if (is_draw(thread))
+        return 0;
+
+    int in_check = position_checkers(pos) != 0;
+    if (ply >= MAX_PLY)
+        return in_check ? 0 : static_eval(thread);
+
+    struct transposition_table *tt = &thread->search->tt;
+    struct tt_data entry;
+    int tt_hit = tt_probe(tt, pos->key, &entry, &thread->tt_stats);
+    if (tt_hit && beta - alpha == 1) {
+        int score = score_from_tt(entry.score, ply);
+        if (tt_cutoff(&entry, score, alpha, beta))
+            return score;
+    }
+
+    // stand pat: the side to move may decline every capture, not in check
+    int best = -SCORE_INFINITE;
+    int eval = SCORE_NONE;
+    int original_alpha = alpha;
+    struct move_picker picker;
+    if (in_check) {
+        move_picker_init(&picker, pos, MOVE_NONE, NULL, NULL, &thread->picker_stats);
+    } else {
+        eval = tt_hit && entry.eval != SCORE_NONE ? entry.eval : static_eval(thread);
+        best = eval;
+        if (best >= beta) {
+            if (!tt_hit)
+                tt_store(tt, pos->key, 0, score_to_tt(best, ply), eval, BOUND_LOWER, MOVE_NONE, &thread->tt_stats);
+            return best;
+        }
+        if (best > alpha)
+            alpha = best;
+        move_picker_init_qsearch(&picker, pos, &thread->picker_stats);
+    }
+
+    move best_move = MOVE_NONE;
+    int move_count = 0;
+    move m;
+    while ((m = move_picker_next(&picker)) != MOVE_NONE) {
+        move_count++;
+        make_move(thread, m);
+        int score = -qsearch(thread, ply + 1, -beta, -alpha);
+        unmake_move(thread, m);
+
+        if (atomic_load_explicit(&thread->search->stop, memory_order_relaxed))
+            return 0;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = m;
+                update_pv(thread, ply, m);
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    if (in_check && move_count == 0)
+        return -SCORE_MATE + ply;
+
+    int bound = best >= beta ? BOUND_LOWER : best > original_alpha ? BOUND_EXACT : BOUND_UPPER;
+    tt_store(tt, pos->key, 0, score_to_tt(best, ply), eval, bound, best_move, &thread->tt_stats);
+
+    return best;
+}
+
+static int pvs(struct search_thread *thread, int depth, int ply, int alpha, int beta)
+{
+    struct position *pos = thread->pos;
+    const struct search_options *options = &thread->search->options;
+    int pv_node = beta - alpha > 1;
+    move excluded = thread->plies[ply].excluded;
+    thread->pv_length[ply] = 0;
+
+    if (ply > 0) {
+        if (should_stop(thread))
+            return 0;
+        if (is_draw(thread))
+            return 0;
+        if (ply >= MAX_PLY)
+            return static_eval(thread);
+
+        // no line from here can beat a mate already found closer to the root
+        alpha = alpha > -SCORE_MATE + ply ? alpha : -SCORE_MATE + ply;
+        beta = beta < SCORE_MATE - ply - 1 ? beta : SCORE_MATE - ply - 1;
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    int in_check = position_checkers(pos) != 0;
+    if (in_check)
+        depth++;
+
+    if (depth <= 0)
+        return qsearch(thread, ply, alpha, beta);
+
+    // a singular search looks at the same position without one move, the
+    // entry of the full search must neither cut it off nor be replaced
+    struct transposition_table *tt = &thread->search->tt;
+    struct tt_data entry;
+    int tt_hit = excluded == MOVE_NONE && tt_probe(tt, pos->key, &entry, &thread->tt_stats);
+    move tt_move = MOVE_NONE;
+    int tt_score = SCORE_NONE;
+    if (tt_hit) {
+        tt_move = entry.best_move;
+        tt_score = score_from_tt(entry.score, ply);
+        if (!pv_node && entry.depth >= depth && tt_cutoff(&entry, tt_score, alpha, beta))
+            return tt_score;
+    }
+
+    // the previous iteration's best move is searched first at the root even
+    // if its entry was overwritten
+    if (ply == 0 && thread->root_best != MOVE_NONE)
+        tt_move = thread->root_best;
+
+    int eval = SCORE_NONE;
+    if (!in_check)
+        eval = tt_hit && entry.eval != SCORE_NONE ? entry.eval : static_eval(thread);
+
+    if (!pv_node && !in_check && excluded == MOVE_NONE) {
+        // reverse futility: far enough above beta that a quiet move can't
+        // bring the score back within a few plies
+        if (options->reverse_futility && depth <= REVERSE_FUTILITY_DEPTH && eval < SCORE_MATE_IN_MAX
+            && eval - REVERSE_FUTILITY_MARGIN * depth >= beta)
+            return eval;
+
+        // Null move: if passing still fails high the position is good
+        // enough to cut. Not in pawn endings, where zugzwang is common, and
+        // never twice in a row. At high depths the cutoff is verified by a
+        // reduced search without null moves for the next few plies.
+        if (options->null_move && depth >= NULL_MOVE_DEPTH && eval >= beta && ply > 0 && ply >= thread->null_move_ply
+            && thread->plies[ply - 1].move != MOVE_NONE && has_non_pawn_material(pos)) {
+            int reduction = 3 + depth / 4;
+            set_ply_null_move(thread, ply);
+            make_null_move(thread);
+            int score = -pvs(thread, depth - 1 - reduction, ply + 1, -beta, -beta + 1);
+            unmake_null_move(thread);
+
+            if (atomic_load_explicit(&thread->search->stop, memory_order_relaxed))
+                return 0;
+
+            if (score >= beta) {
+                // an unproven mate is only worth beta
+                if (score >= SCORE_MATE_IN_MAX)
+                    score = beta;
+                if (depth < NULL_MOVE_VERIFY_DEPTH || thread->null_move_ply > 0)
+                    return score;
+
+                thread->null_move_ply = ply + 3 * (depth - reduction) / 4;
+                int verified = pvs(thread, depth - reduction, ply, beta - 1, beta);
+                thread->null_move_ply = 0;
+                thread->pv_length[ply] = 0;
+                if (verified >= beta)
+                    return score;
+            }
+        }
+    }
+
+    struct quiet_order order;
+    order_quiets(thread, ply, &order);
+    const move *killers = options->killers ? thread->killers[ply] : NULL;
+    struct move_picker picker;
+    move_picker_init(&picker, pos, tt_move, killers, &order, &thread->picker_stats);
+
+    int original_alpha = alpha;
+    move best_move = MOVE_NONE;
+    int best = -SCORE_INFINITE;
+    int move_count = 0;
+    move quiets[64];
+    int quiet_count = 0;
+    move m;
+    while ((m = move_picker_next(&picker)) != MOVE_NONE) {
+        if (m == excluded)
+            continue;
+
+        int quiet = !move_is_noisy(pos, m);
+
+        // futility: a quiet move can't raise a static eval this far below
+        // alpha, unless it gives check
+        int futile = options->futility && !pv_node && !in_check && quiet && move_count > 0
+                  && depth <= FUTILITY_DEPTH && eval + FUTILITY_MARGIN * (depth + 1) <= alpha;
+        int gives_check = move_gives_check(pos, m);
+        if (futile && !gives_check)
+            continue;
+
+        // Singular extension: if every other move fails well below the
+        // hash move's score, the hash move is forced and searched deeper.
+        // When even the others beat beta the node is cut right away. Not
+        // past twice the root depth, so repeated extensions can't make a
+        // line grow without bound.
+        int extension = 0;
+        if (options->singular_extensions && ply > 0 && ply < 2 * thread->root_depth && m == tt_move
+            && depth >= SINGULAR_DEPTH && (entry.bound & BOUND_LOWER) && entry.depth >= depth - 3
+            && tt_score > -SCORE_MATE_IN_MAX && tt_score < SCORE_MATE_IN_MAX) {
+            int singular_beta = tt_score - SINGULAR_MARGIN * depth;
+            thread->plies[ply].excluded = m;
+            int score = pvs(thread, (depth - 1) / 2, ply, singular_beta - 1, singular_beta);
+            thread->plies[ply].excluded = MOVE_NONE;
+            thread->pv_length[ply] = 0;
+
+            if (atomic_load_explicit(&thread->search->stop, memory_order_relaxed))
+                return 0;
+            if (score < singular_beta)
+                extension = 1;
+            else if (singular_beta >= beta)
+                return singular_beta;
+        }
+
+        set_ply_move(thread, ply, m);
+        make_move(thread, m);
+
+        move_count++;
+        if (quiet && quiet_count < 64)
+            quiets[quiet_count++] = m;
+
+        int new_depth = depth - 1 + extension;
+        int score;
+        if (move_count == 1) {
+            score = -pvs(thread, new_depth, ply + 1, -beta, -alpha);
+        } else {
+            // late quiet moves are searched shallower first, a fail high
+            // has to be confirmed at full depth
+            int reduction = 0;
+            if (options->late_move_reductions && quiet && !in_check && !gives_check && depth >= LMR_DEPTH) {
+                reduction = late_move_reduction(depth, move_count) - pv_node;
+                if (reduction < 0)
+                    reduction = 0;
+                if (reduction > new_depth - 1)
+                    reduction = new_depth - 1;
+            }
+
+            // later moves only have to be proven worse than the first
+            score = -pvs(thread, new_depth - reduction, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && reduction > 0)
+                score = -pvs(thread, new_depth, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta && pv_node)
+                score = -pvs(thread, new_depth, ply + 1, -beta, -alpha);
+        }
+        unmake_move(thread, m);
+
+        if (atomic_load_explicit(&thread->search->stop, memory_order_relaxed))
+            return 0;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = m;
+                update_pv(thread, ply, m);
+                if (alpha >= beta) {
+                    if (quiet)
+                        update_quiet_stats(thread, ply, depth, m, quiets, quiet_count);
+                    break;
+                }
+            }
+        }
+    }
+
+    // only a singular search may have skipped the single legal move
+    if (move_count == 0)
+        return excluded != MOVE_NONE ? alpha : in_check ? -SCORE_MATE + ply : 0;
+
+    if (excluded == MOVE_NONE) {
+        int bound = best >= beta ? BOUND_LOWER : best > original_alpha ? BOUND_EXACT : BOUND_UPPER;
+        tt_store(tt, pos->key, depth, score_to_tt(best, ply), eval, bound, best_move, &thread->tt_stats);
+    }
+
+    return best;
+}
+
+// Helpers skip some depths so that the threads spread over several
+// iterations instead of all searching the same tree in lockstep.
+#define SKIP_PATTERNS 20
+static const int skip_size[SKIP_PATTERNS]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int skip_phase[SKIP_PATTERNS] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+static void iterative_deepening(struct search_thread *thread)
+{
+    struct search *search = thread->search;
+    struct search_result *result = thread->result;
+    int pattern = (thread->index - 1) % SKIP_PATTERNS;
+
+    for (int depth = 1; depth <= search->max_depth; ++depth) {
+        if (thread->index > 0 && ((depth + skip_phase[pattern]) / skip_size[pattern]) % 2)
+            continue;
+
+        thread->root_depth = depth;
+        int score = pvs(thread, depth, 0, -SCORE_INFINITE, SCORE_INFINITE);
+
+        // an interrupted iteration is thrown away, its move may be unproven
+        if (atomic_load_explicit(&search->stop, memory_order_relaxed) || thread->pv_length[0] == 0)
+            break;
+
+        thread->root_best = thread->pv[0][0];
+
+        // no point in searching deeper once a forced mate is found
+        int mate = score >= SCORE_MATE_IN_MAX || score <= -SCORE_MATE_IN_MAX;
+
+        // helpers only contribute through the transposition table
+        if (thread->index > 0) {
+            if (mate)
+                break;
+            continue;
+        }
+
+        result->best_move = thread->pv[0][0];
+        result->ponder_move = thread->pv_length[0] > 1 ? thread->pv[0][1] : MOVE_NONE;
+        result->score = score;
+        result->depth = depth;
+
+        if (search->report) {
+            struct search_report report;
+            report.depth = depth;
+            report.score = score;
+            report.nodes = total_nodes(search);
+            report.seconds = now_seconds() - search->start_time;
+            report.nps = report.seconds > 0.0 ? (uint64_t)(report.nodes / report.seconds) : 0;
+            report.tt_stats = thread->tt_stats;
+            report.hashfull = tt_hashfull(&search->tt);
+            report.pv_length = thread->pv_length[0];
+            memcpy(report.pv, thread->pv[0], sizeof(move) * (size_t)report.pv_length);
+            search->report(&report, search->report_context);
+        }
+
+        if (mate)
+            break;
+    }
+}
+
+// Resets the per-search state of a thread. Called by the thread itself once
+// it is pinned, so that the pages are first touched on its own node even
+// where node_alloc() had to fall back to calloc().
+static void prepare_thread(struct search_thread *thread)
+{
+    struct search *search = thread->search;
+    thread->positions[0] = *search->root_pos;
+    thread->pos = &thread->positions[0];
+    thread->stack.count = 0;
+    thread->height = 0;
+    thread->attacks_valid = 0;
+    if (search->options.attack_eval) {
+        attack_map_init(&thread->attacks[0], thread->pos);
+        thread->attacks_valid = 1;
+    }
+    if (search->root_history)
+        thread->history = *search->root_history;
+    else
+        key_history_clear(&thread->history);
+    memset(&thread->tt_stats, 0, sizeof(thread->tt_stats));
+    memset(&thread->picker_stats, 0, sizeof(thread->picker_stats));
+    thread->root_best = MOVE_NONE;
+    memset(thread->killers, 0, sizeof(thread->killers));
+    memset(thread->plies, 0, sizeof(thread->plies));
+    thread->null_move_ply = 0;
+    if (search->clear_pending)
+        history_clear(&thread->move_history);
+}
+
+static void *thread_main(void *arg)
+{
+    struct search_thread *thread = arg;
+    if (thread->search->bind_threads)
+        node_bind_thread(thread->node);
+    prepare_thread(thread);
+    iterative_deepening(thread);
+    return NULL;
+}
+
+struct search_result search_run(struct search *search, const struct position *pos,
+                                 const struct key_history *history, const struct search_limits *limits)
+{
+    struct search_result result = { 0 };
+
+    search->start_time = now_seconds();
+    atomic_store(&search->move_time_ms, limits->move_time_ms);
+    atomic_store(&search->deadline, limits->move_time_ms > 0 && !limits->ponder
+                                        ? search->start_time + limits->move_time_ms / 1000.0 : 0.0);
+    atomic_store(&search->pondering, limits->ponder != 0);
+    atomic_store(&search->ponderhit_time, 0.0);
+    search->node_limit = limits->nodes;
+    search->max_depth = limits->depth > 0 && limits->depth < MAX_PLY ? limits->depth : MAX_PLY - 1;
+    atomic_store(&search->stop, 0);
+    tt_new_search(&search->tt);
+
+    search->root_pos = pos;
+    search->root_history = history;
+    // the counters share the first page with the fields set up by
+    // search_set_threads(), the rest is left to prepare_thread()
+    for (int i = 0; i < search->thread_count; ++i)
+        atomic_store_explicit(&search->threads[i]->nodes, 0, memory_order_relaxed);
+
+    // a legal move is returned even if the first iteration is cut short
+    struct move_list moves;
+    generate_legal_moves(pos, &moves);
+    if (moves.count == 0)
+        return result;
+    result.best_move = moves.moves[0];
+
+    search->threads[0]->result = &result;
+
+    // On a NUMA machine every thread of a parallel search, the main one
+    // included, runs pinned to its node, the caller's thread is left alone.
+    // Otherwise the caller runs the main thread itself, so that many
+    // single-threaded searches side by side aren't all pinned to node 0.
+    search->bind_threads = node_count() > 1 && search->thread_count > 1;
+    int first_helper = search->bind_threads ? 0 : 1;
+
+    // a helper that can't be started is simply left out
+    int started = first_helper;
+    for (; started < search->thread_count; ++started) {
+        struct search_thread *thread = search->threads[started];
+        if (pthread_create(&thread->handle, NULL, thread_main, thread) != 0)
+            break;
+    }
+    for (int i = started > 0 ? started : 1; i < search->thread_count; ++i)
+        prepare_thread(search->threads[i]);
+
+    if (first_helper == 0 && started > 0) {
+        pthread_join(search->threads[0]->handle, NULL);
+    } else {
+        prepare_thread(search->threads[0]);
+        iterative_deepening(search->threads[0]);
+    }
+
+    // a ponder search that ran out of depth holds its move until the
+    // opponent has moved
+    while (atomic_load(&search->pondering) && !atomic_load(&search->stop)) {
+        if (search->poll)
+            search->poll(search->report_context);
+        struct timespec duration = { 0, 1000000 };
+        nanosleep(&duration, NULL);
+    }
+
+    search_stop(search);
+    for (int i = 1; i < started; ++i)
+        pthread_join(search->threads[i]->handle, NULL);
+    search->clear_pending = 0;
+
+    for (int i = 0; i < search->thread_count; ++i) {
+        struct search_thread *thread = search->threads[i];
+        result.tt_stats.probes += thread->tt_stats.probes;
+        result.tt_stats.hits += thread->tt_stats.hits;
+        result.tt_stats.collisions += thread->tt_stats.collisions;
+        search->picker_stats.pickers += thread->picker_stats.pickers;
+        search->picker_stats.quiet_generations += thread->picker_stats.quiet_generations;
+    }
+    result.nodes = total_nodes(search);
+    double ponderhit_time = atomic_load(&search->ponderhit_time);
+    if (limits->ponder && ponderhit_time > 0.0)
+        result.ponder_seconds = ponderhit_time - search->start_time;
+
+    return result;
+}
+
+void search_print_report(FILE *out, const struct search_report *report)
+{
+    fprintf(out, "depth %2d score ", report->depth);
+    if (report->score >= SCORE_MATE_IN_MAX)
+        fprintf(out, "mate %d", (SCORE_MATE - report->score + 1) / 2);
+    else if (report->score <= -SCORE_MATE_IN_MAX)
+        fprintf(out, "mate -%d", (SCORE_MATE + report->score) / 2);
+    else
+        fprintf(out, "cp %d", report->score);
+
+    fprintf(out, " nodes %llu nps %llu time %.3f hashfull %d tthit %.1f%% pv", (unsigned long long)report->nodes,
+            (unsigned long long)report->nps, report->seconds, report->hashfull,
+            report->tt_stats.probes ? 100.0 * (double)report->tt_stats.hits / (double)report->tt_stats.probes : 0.0);
+    for (int i = 0; i < report->pv_length; ++i) {
+        char uci[6];
+        move_to_uci(report->pv[i], uci);
+        fprintf(out, " %s", uci);
+    }
+    fprintf(out, "\n");
+}
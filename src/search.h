@@ -0,0 +1,151 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "draw.h"
+#include "move.h"
+#include "movepick.h"
+#include "position.h"
+#include "tt.h"
+
+#define MAX_PLY 128
+#define SEARCH_MAX_THREADS 256
+
+#define SCORE_INFINITE 32000
+#define SCORE_MATE     31000
+// scores beyond this are mates, the distance is SCORE_MATE - |score| plies
+#define SCORE_MATE_IN_MAX (SCORE_MATE - MAX_PLY)
+// static evaluation not computed, e.g. when in check
+#define SCORE_NONE (-SCORE_INFINITE - 1)
+
+// A zero field means no limit of that kind, without any limit the search
+// runs until search_stop() is called or MAX_PLY is reached. A ponder search
+// ignores the move time and doesn't return before search_ponderhit() or
+// search_stop(); the move time starts counting at the ponder hit. The node
+// limit counts the nodes of all threads together.
+struct search_limits {
+    int depth;
+    int move_time_ms;
+    uint64_t nodes;
+    int ponder;
+};
+
+// sent after every completed iteration of the main thread, nodes are
+// summed over all threads
+struct search_report {
+    int depth;
+    int score;
+    uint64_t nodes;
+    double seconds;
+    uint64_t nps;
+    struct tt_stats tt_stats;
+    int hashfull;
+    int pv_length;
+    move pv[MAX_PLY];
+};
+
+typedef void (*search_report_fn)(const struct search_report *report, void *context);
+
+// Called by the main search thread every few thousand nodes and while a
+// ponder search holds its move, with the report context. It may call
+// search_stop() or search_ponderhit().
+typedef void (*search_poll_fn)(void *context);
+
+struct search_result {
+    move best_move;
+    move ponder_move;  // expected reply, MOVE_NONE if the PV ended early
+    int score;
+    int depth;
+    uint64_t nodes;
+    struct tt_stats tt_stats;  // all threads
+    double ponder_seconds;     // searched before the ponder hit, 0 without one
+};
+
+// Move ordering heuristics, selectivity and evaluation terms, all enabled
+// by search_init(). Only change them between searches, e.g. to measure what
+// each one saves.
+struct search_options {
+    int killers;
+    int history;
+    int countermoves;
+    int continuation_history;
+    int null_move;
+    int late_move_reductions;
+    int reverse_futility;
+    int futility;
+    int singular_extensions;
+    int attack_eval;  // keep an attack map through the tree for mobility and threats
+};
+
+struct search_thread;
+
+// Iterative deepening PVS with quiescence search. One struct search can run
+// any number of searches one after another; search_stop() may be called
+// from any thread while search_run() is busy.
+//
+// With more than one thread the search is Lazy SMP: helper threads search
+// the same root at staggered depths and only share the transposition
+// table, the main thread alone decides the result and reports.
+struct search {
+    atomic_bool stop;
+    search_report_fn report;
+    search_poll_fn poll;  // may be NULL
+    void *report_context;
+    struct picker_stats picker_stats;  // summed over all threads and searches
+    struct transposition_table tt;
+    int thread_count;
+    struct search_thread **threads;
+    struct search_options options;
+
+    // limits of the running search
+    double start_time;
+    _Atomic double deadline;
+    atomic_bool pondering;
+    _Atomic double ponderhit_time;
+    _Atomic int move_time_ms;
+    uint64_t node_limit;
+    int max_depth;
+    int bind_threads;
+    const struct position *root_pos;
+    const struct key_history *root_history;
+
+    int clear_pending;  // search_clear() was called, threads clear their tables
+};
+
+// Allocates a hash_mb transposition table, report may be NULL. Returns -1
+// if the table or the thread state can't be allocated.
+int search_init(struct search *search, size_t hash_mb, search_report_fn report, void *report_context);
+void search_free(struct search *search);
+
+// One search thread by default, returns -1 if the state can't be allocated.
+// On machines with several NUMA nodes each thread's state is allocated on
+// the node the thread is pinned to while searching: with libnuma directly,
+// otherwise by the pinned thread touching its own state first.
+int search_set_threads(struct search *search, int count);
+
+// nodes searched by one thread in the current or last search
+uint64_t search_thread_nodes(const struct search *search, int index);
+
+// forget everything learned so far, e.g. before a new game
+void search_clear(struct search *search);
+
+// Searches pos within limits and returns the best move of the last
+// completed iteration. history holds the game's earlier positions for
+// repetition detection and may be NULL.
+struct search_result search_run(struct search *search, const struct position *pos,
+                                 const struct key_history *history, const struct search_limits *limits);
+
+void search_stop(struct search *search);
+
+// The opponent played the move a ponder search assumed: from now on it is a
+// normal search with its move time. Like search_stop() this may be called
+// from any thread.
+void search_ponderhit(struct search *search);
+
+// one line: depth, score, nodes, nps, time and PV in UCI notation
+void search_print_report(FILE *out, const struct search_report *report);
+
+#endif
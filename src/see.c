@@ -0,0 +1,106 @@
+#include "see.h"
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "movegen.h"
+
+static const int see_values[PIECE_TYPE_COUNT] = { 100, 320, 330, 500, 900, 20000 };
+
+int see(const struct position *pos, move m)
+{
+    int from = move_from(m);
+    int to = move_to(m);
+
+    if (move_flag(m) == MOVE_CASTLING)
+        return 0;
+
+    int piece = position_piece_at(pos, from);
+    int side = piece_color(piece);
+    uint64_t occupied = position_occupied(pos) ^ square_bb(from);
+
+    // swap list: gain[d] is the score for the side making capture d if the
+    // exchange stopped right after it
+    int gain[32];
+    int depth = 0;
+
+    int captured = position_piece_at(pos, to);
+    gain[0] = captured != NO_PIECE ? see_values[piece_type(captured)] : 0;
+    if (move_flag(m) == MOVE_EN_PASSANT) {
+        occupied ^= square_bb(to + (side == WHITE ? -8 : 8));
+        gain[0] = see_values[PAWN];
+    }
+
+    // value of the piece now standing on the square
+    int on_square = see_values[piece_type(piece)];
+    if (move_flag(m) == MOVE_PROMOTION) {
+        gain[0] += see_values[move_promotion(m)] - see_values[PAWN];
+        on_square = see_values[move_promotion(m)];
+    }
+
+    uint64_t bishops = pos->pieces[BISHOP] | pos->pieces[QUEEN];
+    uint64_t rooks = pos->pieces[ROOK] | pos->pieces[QUEEN];
+    uint64_t attackers = attackers_to(pos, to, occupied) & occupied;
+
+    for (;;) {
+        side ^= 1;
+        uint64_t own = attackers & pos->colors[side];
+        if (!own)
+            break;
+
+        // least valuable attacker
+        int type = PAWN;
+        while (!(own & pos->pieces[type]))
+            ++type;
+
+        // the king may only take last
+        if (type == KING && (attackers & pos->colors[side ^ 1]))
+            break;
+
+        depth++;
+        gain[depth] = on_square - gain[depth - 1];
+        on_square = see_values[type];
+
+        occupied ^= square_bb(lsb(own & pos->pieces[type]));
+
+        // sliders behind the piece that just captured join in
+        if (type == PAWN || type == BISHOP || type == QUEEN)
+            attackers |= bishop_attacks(to, occupied) & bishops;
+        if (type == ROOK || type == QUEEN)
+            attackers |= rook_attacks(to, occupied) & rooks;
+        attackers &= occupied;
+    }
+
+    // each side may decline to continue the exchange
+    while (depth) {
+        if (gain[depth] > -gain[depth - 1])
+            gain[depth - 1] = -gain[depth];
+        depth--;
+    }
+
+    return gain[0];
+}
+
+uint64_t hanging_pieces(const struct position *pos, int color)
+{
+    uint64_t occupied = position_occupied(pos);
+    uint64_t pieces = pos->colors[color] & ~pos->pieces[KING];
+    uint64_t hanging = 0;
+
+    while (pieces) {
+        int square = pop_lsb(&pieces);
+        uint64_t attackers = attackers_to(pos, square, occupied) & pos->colors[color ^ 1];
+        if (!attackers)
+            continue;
+
+        // the cheapest attacker starts the exchange
+        int type = PAWN;
+        while (!(attackers & pos->pieces[type]))
+            ++type;
+
+        move capture = encode_move(lsb(attackers & pos->pieces[type]), square, MOVE_NORMAL, 0);
+        if (see(pos, capture) > 0)
+            hanging |= square_bb(square);
+    }
+
+    return hanging;
+}
@@ -0,0 +1,19 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include <stdint.h>
+
+#include "move.h"
+#include "position.h"
+
+// Static exchange evaluation: the material balance, in centipawns and from
+// the moving side's point of view, of m followed by the best sequence of
+// recaptures on its destination square. Works on attacker sets with x-rays
+// revealed as pieces are used up, nothing is made or unmade. Pins are not
+// considered.
+int see(const struct position *pos, move m);
+
+// pieces of color that the opponent can win material by capturing
+uint64_t hanging_pieces(const struct position *pos, int color);
+
+#endif
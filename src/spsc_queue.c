@@ -0,0 +1,56 @@
+#include "spsc_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int spsc_init(struct spsc_queue *queue, size_t capacity, size_t element_size)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    queue->elements = calloc(size, element_size);
+    if (!queue->elements) {
+        printf("Error: failed to allocate queue of %zu elements\n", size);
+        return -1;
+    }
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->mask = size - 1;
+    queue->element_size = element_size;
+    return 0;
+}
+
+void spsc_free(struct spsc_queue *queue)
+{
+    free(queue->elements);
+    queue->elements = NULL;
+}
+
+int spsc_push(struct spsc_queue *queue, const void *element)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head > queue->mask)
+        return -1;
+
+    memcpy(queue->elements + (tail & queue->mask) * queue->element_size, element, queue->element_size);
+    // publishes the element written above
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+int spsc_pop(struct spsc_queue *queue, void *element)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail)
+        return 0;
+
+    memcpy(element, queue->elements + (head & queue->mask) * queue->element_size, queue->element_size);
+    // hands the slot back to the producer only after it has been read
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return 1;
+}
@@ -0,0 +1,29 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Bounded single-producer single-consumer ring of fixed-size elements.
+// Neither side ever blocks or takes a lock: push fails when the ring is
+// full and pop fails when it is empty. The indices sit on separate cache
+// lines so the two threads don't share one.
+struct spsc_queue {
+    _Alignas(64) _Atomic size_t head;  // next element to pop, written by the consumer
+    _Alignas(64) _Atomic size_t tail;  // next free slot, written by the producer
+    _Alignas(64) size_t mask;
+    size_t element_size;
+    unsigned char *elements;
+};
+
+// capacity is rounded up to a power of two, returns -1 if allocation fails
+int spsc_init(struct spsc_queue *queue, size_t capacity, size_t element_size);
+void spsc_free(struct spsc_queue *queue);
+
+// producer side, returns -1 when full
+int spsc_push(struct spsc_queue *queue, const void *element);
+
+// consumer side, returns 0 when empty and 1 when an element was copied out
+int spsc_pop(struct spsc_queue *queue, void *element);
+
+#endif
@@ -0,0 +1,317 @@
+// Build-time generator for the attack tables and Zobrist keys. The tables
+// are written as C initialisers so the programs start without computing
+// anything and the data lives in read-only, shareable pages.
+//
+// Usage: tablegen <output directory>
+// Writes attack_tables.h (included by attacks.c) and zobrist_keys.h
+// (included by zobrist.c).
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "bitboard.h"
+
+#define BISHOP_TABLE_SIZE 0x1480
+#define ROOK_TABLE_SIZE   0x19000
+
+struct generated_magic {
+    uint64_t mask;
+    uint64_t magic;
+    unsigned int offset;
+    unsigned int shift;
+};
+
+static uint64_t pawn_attacks[2][64];
+static uint64_t knight_attacks[64];
+static uint64_t king_attacks[64];
+static uint64_t between_bb[64][64];
+static uint64_t line_bb[64][64];
+
+static struct generated_magic bishop_magics[64];
+static struct generated_magic rook_magics[64];
+static uint64_t bishop_table[BISHOP_TABLE_SIZE];
+static uint64_t rook_table[ROOK_TABLE_SIZE];
+static uint64_t bishop_pext_table[BISHOP_TABLE_SIZE];
+static uint64_t rook_pext_table[ROOK_TABLE_SIZE];
+
+static uint64_t zobrist_pieces[16][64];
+static uint64_t zobrist_castling[16];
+static uint64_t zobrist_en_passant[8];
+static uint64_t zobrist_side;
+
+static const int bishop_directions[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+static const int rook_directions[4][2]   = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+static uint64_t random_state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t random_u64(void)
+{
+    // xorshift64*
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return random_state * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t pext_software(uint64_t value, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (value & mask & -mask)
+            result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+// offset from square by (file, rank) steps, 0 when it leaves the board
+static uint64_t step_bb(int square, int file_step, int rank_step)
+{
+    int file = (square & 7) + file_step;
+    int rank = (square >> 3) + rank_step;
+    if (file < 0 || file > 7 || rank < 0 || rank > 7)
+        return 0;
+
+    return square_bb(rank * 8 + file);
+}
+
+static uint64_t sliding_attack(const int directions[4][2], int square, uint64_t occupied)
+{
+    uint64_t attacks = 0;
+
+    for (int d = 0; d < 4; ++d) {
+        int file = square & 7;
+        int rank = square >> 3;
+
+        for (;;) {
+            file += directions[d][0];
+            rank += directions[d][1];
+            if (file < 0 || file > 7 || rank < 0 || rank > 7)
+                break;
+
+            uint64_t bb = square_bb(rank * 8 + file);
+            attacks |= bb;
+            if (occupied & bb)
+                break;
+        }
+    }
+
+    return attacks;
+}
+
+static void init_magics(const int directions[4][2], struct generated_magic magics[64], uint64_t *table, uint64_t *pext_table)
+{
+    static uint64_t occupancy[4096];
+    static uint64_t reference[4096];
+    static int epoch[4096];
+    int current = 0;
+    unsigned int offset = 0;
+
+    for (int square = 0; square < 64; ++square) {
+        struct generated_magic *m = &magics[square];
+
+        // board edges are not relevant unless the piece is on them
+        uint64_t file_bb = FILE_A_BB << (square & 7);
+        uint64_t rank_bb = RANK_1_BB << (8 * (square >> 3));
+        uint64_t edges = ((RANK_1_BB | RANK_8_BB) & ~rank_bb) | ((FILE_A_BB | FILE_H_BB) & ~file_bb);
+
+        m->mask   = sliding_attack(directions, square, 0) & ~edges;
+        m->shift  = 64 - popcount(m->mask);
+        m->offset = offset;
+
+        uint64_t *attacks = table + offset;
+        uint64_t *pext_attacks = pext_table + offset;
+
+        // enumerate every subset of the mask (carry-rippler)
+        int size = 0;
+        uint64_t b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = sliding_attack(directions, square, b);
+            pext_attacks[pext_software(b, m->mask)] = reference[size];
+            size++;
+            b = (b - m->mask) & m->mask;
+        } while (b);
+
+        // search for a magic that maps every subset to a consistent slot
+        for (int i = 0; i < size;) {
+            do {
+                m->magic = random_u64() & random_u64() & random_u64();
+            } while (popcount((m->magic * m->mask) >> 56) < 6);
+
+            for (++current, i = 0; i < size; ++i) {
+                unsigned int index = (unsigned int)(((occupancy[i] & m->mask) * m->magic) >> m->shift);
+
+                if (epoch[index] < current) {
+                    epoch[index] = current;
+                    attacks[index] = reference[i];
+                } else if (attacks[index] != reference[i]) {
+                    break;
+                }
+            }
+        }
+
+        offset += (unsigned int)size;
+    }
+}
+
+static void init_attacks(void)
+{
+    static const int knight_steps[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+    static const int king_steps[8][2]   = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+
+    for (int square = 0; square < 64; ++square) {
+        pawn_attacks[0][square] = step_bb(square, -1, 1) | step_bb(square, 1, 1);
+        pawn_attacks[1][square] = step_bb(square, -1, -1) | step_bb(square, 1, -1);
+
+        for (int i = 0; i < 8; ++i) {
+            knight_attacks[square] |= step_bb(square, knight_steps[i][0], knight_steps[i][1]);
+            king_attacks[square]   |= step_bb(square, king_steps[i][0], king_steps[i][1]);
+        }
+    }
+
+    init_magics(bishop_directions, bishop_magics, bishop_table, bishop_pext_table);
+    init_magics(rook_directions, rook_magics, rook_table, rook_pext_table);
+
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            const int (*directions)[2];
+            if (sliding_attack(rook_directions, a, 0) & square_bb(b))
+                directions = rook_directions;
+            else if (sliding_attack(bishop_directions, a, 0) & square_bb(b))
+                directions = bishop_directions;
+            else
+                continue;
+
+            line_bb[a][b] = (sliding_attack(directions, a, 0) & sliding_attack(directions, b, 0)) | square_bb(a) | square_bb(b);
+            between_bb[a][b] = sliding_attack(directions, a, square_bb(b)) & sliding_attack(directions, b, square_bb(a));
+        }
+    }
+}
+
+static void init_zobrist(void)
+{
+    // fixed seed so keys (and anything stored by key) are stable between builds
+    uint64_t state = 0x3243F6A8885A308DULL;
+
+    // index 0 (NO_PIECE) and the unused piece codes keep zero keys
+    for (int piece = 1; piece < 16; ++piece) {
+        if ((piece & 7) == 0 || (piece & 7) == 7)
+            continue;
+        for (int square = 0; square < 64; ++square)
+            zobrist_pieces[piece][square] = splitmix64(&state);
+    }
+
+    // castling keys are combined per right so any set of rights is one lookup
+    uint64_t rights[4];
+    for (int i = 0; i < 4; ++i)
+        rights[i] = splitmix64(&state);
+    for (int mask = 0; mask < 16; ++mask) {
+        for (int i = 0; i < 4; ++i) {
+            if (mask & (1 << i))
+                zobrist_castling[mask] ^= rights[i];
+        }
+    }
+
+    for (int file = 0; file < 8; ++file)
+        zobrist_en_passant[file] = splitmix64(&state);
+
+    zobrist_side = splitmix64(&state);
+}
+
+static void write_values(FILE *out, const uint64_t *values, size_t count, const char *indent)
+{
+    for (size_t i = 0; i < count; ++i)
+        fprintf(out, "%s%s0x%016llxULL,", i % 4 ? " " : "\n", i % 4 ? "" : indent, (unsigned long long)values[i]);
+}
+
+// rows is the outer dimension of a two dimensional table, 0 for a flat one
+static void write_array(FILE *out, const char *declaration, const uint64_t *values, size_t count, size_t rows)
+{
+    fprintf(out, "%s = {", declaration);
+    if (rows == 0) {
+        write_values(out, values, count, "    ");
+    } else {
+        for (size_t row = 0; row < rows; ++row) {
+            fprintf(out, "\n    {");
+            write_values(out, values + row * (count / rows), count / rows, "        ");
+            fprintf(out, "\n    },");
+        }
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+static void write_magics(FILE *out, const char *name, const struct generated_magic magics[64], const char *table, const char *pext_table)
+{
+    fprintf(out, "const struct magic %s[64] = {\n", name);
+    for (int square = 0; square < 64; ++square) {
+        fprintf(out, "    { 0x%016llxULL, 0x%016llxULL, %s + %u, %s + %u, %u },\n",
+                (unsigned long long)magics[square].mask, (unsigned long long)magics[square].magic,
+                table, magics[square].offset, pext_table, magics[square].offset, magics[square].shift);
+    }
+    fprintf(out, "};\n\n");
+}
+
+static FILE *open_output(const char *directory, const char *name)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        printf("Error: failed to open %s\n", path);
+        return NULL;
+    }
+
+    fprintf(out, "// Generated by tablegen during the build, do not edit.\n\n");
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        printf("Usage: %s <output directory>\n", argv[0]);
+        return -1;
+    }
+
+    init_attacks();
+    init_zobrist();
+
+    FILE *out = open_output(argv[1], "attack_tables.h");
+    if (!out)
+        return -1;
+
+    write_array(out, "const uint64_t pawn_attacks[2][64]", &pawn_attacks[0][0], 2 * 64, 2);
+    write_array(out, "const uint64_t knight_attacks[64]", knight_attacks, 64, 0);
+    write_array(out, "const uint64_t king_attacks[64]", king_attacks, 64, 0);
+    write_array(out, "const uint64_t between_bb[64][64]", &between_bb[0][0], 64 * 64, 64);
+    write_array(out, "const uint64_t line_bb[64][64]", &line_bb[0][0], 64 * 64, 64);
+    write_array(out, "static const uint64_t bishop_table[0x1480]", bishop_table, BISHOP_TABLE_SIZE, 0);
+    write_array(out, "static const uint64_t rook_table[0x19000]", rook_table, ROOK_TABLE_SIZE, 0);
+    write_array(out, "static const uint64_t bishop_pext_table[0x1480]", bishop_pext_table, BISHOP_TABLE_SIZE, 0);
+    write_array(out, "static const uint64_t rook_pext_table[0x19000]", rook_pext_table, ROOK_TABLE_SIZE, 0);
+    write_magics(out, "bishop_magics", bishop_magics, "bishop_table", "bishop_pext_table");
+    write_magics(out, "rook_magics", rook_magics, "rook_table", "rook_pext_table");
+
+    if (fclose(out) != 0)
+        return -1;
+
+    out = open_output(argv[1], "zobrist_keys.h");
+    if (!out)
+        return -1;
+
+    write_array(out, "const uint64_t zobrist_pieces[16][64]", &zobrist_pieces[0][0], 16 * 64, 16);
+    write_array(out, "const uint64_t zobrist_castling[16]", zobrist_castling, 16, 0);
+    write_array(out, "const uint64_t zobrist_en_passant[8]", zobrist_en_passant, 8, 0);
+    fprintf(out, "const uint64_t zobrist_side = 0x%016llxULL;\n", (unsigned long long)zobrist_side);
+
+    return fclose(out) != 0 ? -1 : 0;
+}
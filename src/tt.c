@@ -0,0 +1,212 @@
+#include "tt.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "numa_nodes.h"
+
+// data layout: move 0-15, score 16-31, eval 32-47, depth 48-55, bound 56-57
+// and generation 58-63
+#define GENERATION_MASK 63
+
+static inline uint64_t pack(move best_move, int score, int eval, int depth, int bound, int generation)
+{
+    return (uint64_t)best_move
+         | (uint64_t)(uint16_t)score << 16
+         | (uint64_t)(uint16_t)eval << 32
+         | (uint64_t)(uint8_t)depth << 48
+         | (uint64_t)bound << 56
+         | (uint64_t)generation << 58;
+}
+
+static inline int data_depth(uint64_t data)      { return (uint8_t)(data >> 48); }
+static inline int data_bound(uint64_t data)      { return (int)(data >> 56) & 3; }
+static inline int data_generation(uint64_t data) { return (int)(data >> 58); }
+
+int tt_init(struct transposition_table *tt, size_t mb)
+{
+    uint64_t count = (uint64_t)mb * 1024 * 1024 / sizeof(struct tt_bucket);
+    if (count == 0)
+        count = 1;
+
+    if (large_alloc(&tt->memory, count * sizeof(struct tt_bucket)) != 0) {
+        printf("Error: failed to allocate %zu MB transposition table\n", mb);
+        tt->buckets = NULL;
+        tt->bucket_count = 0;
+        return -1;
+    }
+
+    tt->buckets = tt->memory.memory;
+    tt->bucket_count = count;
+
+    // the policy has to be set before the clear faults the pages in
+    tt->interleaved = node_interleave_tables && node_count() > 1;
+    if (node_interleave_tables)
+        node_interleave(tt->memory.memory, tt->memory.size);
+    tt_clear(tt);
+    tt->huge_bytes = large_alloc_huge_bytes(&tt->memory);
+    return 0;
+}
+
+void tt_print_memory(FILE *out, const struct transposition_table *tt)
+{
+    size_t mb = (tt->bucket_count * sizeof(struct tt_bucket)) >> 20;
+    fprintf(out, "hash: %zu MB with %s, %zu MB in huge pages%s\n", mb, page_kind_name(tt->memory.pages),
+            tt->huge_bytes >> 20, tt->interleaved ? ", interleaved over all nodes" : "");
+}
+
+void tt_free(struct transposition_table *tt)
+{
+    large_free(&tt->memory);
+    tt->buckets = NULL;
+    tt->bucket_count = 0;
+}
+
+#define CLEAR_CHUNK ((size_t)32 << 20)
+#define CLEAR_MAX_THREADS 256
+
+struct clear_job {
+    char *begin;
+    size_t size;
+};
+
+static void *clear_worker(void *arg)
+{
+    struct clear_job *job = arg;
+    memset(job->begin, 0, job->size);
+    return NULL;
+}
+
+void tt_clear(struct transposition_table *tt)
+{
+    size_t size = tt->bucket_count * sizeof(struct tt_bucket);
+    size_t threads = size / CLEAR_CHUNK + 1;
+    size_t cores = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > cores)
+        threads = cores;
+    if (threads > CLEAR_MAX_THREADS)
+        threads = CLEAR_MAX_THREADS;
+    if (threads < 1)
+        threads = 1;
+
+    // whole buckets per thread, the last one takes the remainder
+    struct clear_job jobs[CLEAR_MAX_THREADS];
+    pthread_t workers[CLEAR_MAX_THREADS];
+    size_t share = tt->bucket_count / threads * sizeof(struct tt_bucket);
+    for (size_t i = 0; i < threads; ++i) {
+        jobs[i].begin = (char *)tt->buckets + i * share;
+        jobs[i].size = i + 1 < threads ? share : size - i * share;
+    }
+
+    size_t started = 1;
+    for (; started < threads; ++started) {
+        if (pthread_create(&workers[started], NULL, clear_worker, &jobs[started]) != 0)
+            break;
+    }
+    clear_worker(&jobs[0]);
+    // anything a thread couldn't be started for is cleared here
+    for (size_t i = started; i < threads; ++i)
+        clear_worker(&jobs[i]);
+    for (size_t i = 1; i < started; ++i)
+        pthread_join(workers[i], NULL);
+
+    tt->generation = 0;
+}
+
+void tt_new_search(struct transposition_table *tt)
+{
+    tt->generation = (tt->generation + 1) & GENERATION_MASK;
+}
+
+int tt_probe(const struct transposition_table *tt, uint64_t key, struct tt_data *data, struct tt_stats *stats)
+{
+    struct tt_bucket *bucket = tt_bucket(tt, key);
+    stats->probes++;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; ++i) {
+        struct tt_entry *entry = &bucket->entries[i];
+        uint64_t packed = atomic_load_explicit(&entry->data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+        if ((check ^ packed) != key || data_bound(packed) == BOUND_NONE)
+            continue;
+
+        data->best_move = (move)packed;
+        data->score = (int16_t)(packed >> 16);
+        data->eval = (int16_t)(packed >> 32);
+        data->depth = (uint8_t)data_depth(packed);
+        data->bound = (uint8_t)data_bound(packed);
+        stats->hits++;
+        return 1;
+    }
+
+    return 0;
+}
+
+void tt_store(struct transposition_table *tt, uint64_t key, int depth, int score, int eval, int bound,
+              move best_move, struct tt_stats *stats)
+{
+    struct tt_bucket *bucket = tt_bucket(tt, key);
+    struct tt_entry *replace = NULL;
+    int replace_worth = 0;
+
+    if (depth < 0)
+        depth = 0;
+    if (depth > 255)
+        depth = 255;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; ++i) {
+        struct tt_entry *entry = &bucket->entries[i];
+        uint64_t packed = atomic_load_explicit(&entry->data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+        if ((check ^ packed) == key) {
+            // keep a deeper result for the same position unless the new one
+            // is exact or the old one is from an earlier search
+            if (bound != BOUND_EXACT && data_generation(packed) == tt->generation
+                && depth + 3 < data_depth(packed))
+                return;
+            if (best_move == MOVE_NONE)
+                best_move = (move)packed;
+            replace = entry;
+            break;
+        }
+
+        // the shallowest and oldest entry goes, each search of age counts
+        // as eight plies of depth
+        int age = (tt->generation - data_generation(packed)) & GENERATION_MASK;
+        int worth = data_bound(packed) == BOUND_NONE ? -1000 : data_depth(packed) - 8 * age;
+        if (!replace || worth < replace_worth) {
+            replace = entry;
+            replace_worth = worth;
+        }
+    }
+
+    uint64_t old = atomic_load_explicit(&replace->data, memory_order_relaxed);
+    if (data_bound(old) != BOUND_NONE && data_generation(old) == tt->generation
+        && ((atomic_load_explicit(&replace->check, memory_order_relaxed) ^ old) != key))
+        stats->collisions++;
+
+    uint64_t packed = pack(best_move, score, eval, depth, bound, tt->generation);
+    atomic_store_explicit(&replace->check, key ^ packed, memory_order_relaxed);
+    atomic_store_explicit(&replace->data, packed, memory_order_relaxed);
+}
+
+int tt_hashfull(const struct transposition_table *tt)
+{
+    uint64_t samples = tt->bucket_count < 1000 ? tt->bucket_count : 1000;
+    int used = 0;
+
+    for (uint64_t i = 0; i < samples; ++i) {
+        for (int j = 0; j < TT_BUCKET_ENTRIES; ++j) {
+            uint64_t packed = atomic_load_explicit(&tt->buckets[i].entries[j].data, memory_order_relaxed);
+            if (data_bound(packed) != BOUND_NONE && data_generation(packed) == tt->generation)
+                used++;
+        }
+    }
+
+    return samples ? (int)(used * 1000 / (samples * TT_BUCKET_ENTRIES)) : 0;
+}
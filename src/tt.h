@@ -0,0 +1,97 @@
+#ifndef TT_H
+#define TT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "large_alloc.h"
+#include "move.h"
+
+enum tt_bound {
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT
+};
+
+// Entries are written without locks. check holds the key xor'ed with the
+// data, so an entry torn by two threads storing at once fails verification
+// and reads as a miss.
+struct tt_entry {
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+};
+
+#define TT_BUCKET_ENTRIES 4
+
+// one cache line, a probe never touches more than one
+struct tt_bucket {
+    _Alignas(64) struct tt_entry entries[TT_BUCKET_ENTRIES];
+};
+
+_Static_assert(sizeof(struct tt_bucket) == 64, "tt_bucket must be one cache line");
+
+struct transposition_table {
+    struct tt_bucket *buckets;
+    uint64_t bucket_count;
+    uint8_t generation;
+    struct large_alloc memory;  // memory.pages is the page kind obtained
+    size_t huge_bytes;          // backed by huge pages after the first clear
+    int interleaved;            // spread over all NUMA nodes
+};
+
+// unpacked contents of an entry
+struct tt_data {
+    move best_move;
+    int16_t score;
+    int16_t eval;
+    uint8_t depth;
+    uint8_t bound;
+};
+
+// per thread, so counting never contends between threads
+struct tt_stats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t collisions;  // stores that evicted another position of the current search
+};
+
+// Size in MB, any size works. The table is backed by huge pages where the
+// system provides them. Returns -1 if the memory can't be allocated.
+int tt_init(struct transposition_table *tt, size_t mb);
+void tt_free(struct transposition_table *tt);
+
+// one line: size, page kind and how much of it is in huge pages
+void tt_print_memory(FILE *out, const struct transposition_table *tt);
+
+// Zeroes the table with one thread per 32 MB, up to the number of cores.
+// The first clear also faults every page in, so the search doesn't pay for
+// that later.
+void tt_clear(struct transposition_table *tt);
+
+// ages every entry by one search, older entries are replaced first
+void tt_new_search(struct transposition_table *tt);
+
+static inline struct tt_bucket *tt_bucket(const struct transposition_table *tt, uint64_t key)
+{
+    // multiply-shift maps the key onto any bucket count without a modulo
+    return &tt->buckets[(uint64_t)(((unsigned __int128)key * tt->bucket_count) >> 64)];
+}
+
+// issue as soon as a child key is known, the probe comes a little later
+static inline void tt_prefetch(const struct transposition_table *tt, uint64_t key)
+{
+    __builtin_prefetch(tt_bucket(tt, key));
+}
+
+int tt_probe(const struct transposition_table *tt, uint64_t key, struct tt_data *data, struct tt_stats *stats);
+
+void tt_store(struct transposition_table *tt, uint64_t key, int depth, int score, int eval, int bound,
+              move best_move, struct tt_stats *stats);
+
+// used entries of the current search per mille, sampled from the first buckets
+int tt_hashfull(const struct transposition_table *tt);
+
+#endif
@@ -0,0 +1,3 @@
+#include "zobrist.h"
+
+#include "zobrist_keys.h"
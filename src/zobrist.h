@@ -0,0 +1,13 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+// random keys xor'ed together to form the 64 bit hash of a position,
+// generated at build time by tablegen from a fixed seed
+extern const uint64_t zobrist_pieces[16][64];
+extern const uint64_t zobrist_castling[16];
+extern const uint64_t zobrist_en_passant[8];
+extern const uint64_t zobrist_side;
+
+#endif